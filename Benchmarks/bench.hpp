@@ -0,0 +1,111 @@
+//
+// bench.hpp
+//
+// Minimal benchmark harness, no dependencies besides the standard library.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+	/* Keep a value observable so the optimizer cannot drop the work producing it */
+	template<class T>
+	inline void keep(T&& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	/* Passed to every benchmark, which runs its body ``iterations`` times and may report counters */
+	struct state {
+		std::size_t iterations = 1;
+		std::vector<std::pair<std::string, double>> counters;
+		const char* skipped = nullptr; /* Reason, when the benchmark cannot run in this configuration */
+
+		void skip(const char* reason) {
+			skipped = reason;
+		}
+
+		void counter(const std::string& name, double value) {
+			for (auto& pair : counters) {
+				if (pair.first == name) {
+					pair.second = value;
+					return;
+				}
+			}
+			counters.emplace_back(name, value);
+		}
+	};
+
+	using function = void(*)(state&);
+
+	struct entry {
+		const char* name;
+		function run;
+	};
+
+	inline std::vector<entry>& registry() {
+		static std::vector<entry> entries;
+		return entries;
+	}
+
+	struct registration {
+		registration(const char* name, function run) {
+			registry().push_back({ name, run });
+		}
+	};
+
+	/* Run every benchmark whose name contains filter, doubling iterations until it runs long enough */
+	inline int run_all(const char* filter, double min_seconds = 0.2) {
+		std::printf("%-48s %14s %12s\n", "benchmark", "ns/iter", "iterations");
+		for (const auto& bench : registry()) {
+			if (filter && !std::strstr(bench.name, filter)) {
+				continue;
+			}
+
+			state s;
+			double seconds = 0.0;
+			for (;;) {
+				s.counters.clear();
+				const auto start = std::chrono::steady_clock::now();
+				bench.run(s);
+				seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (s.skipped || seconds >= min_seconds || s.iterations >= (std::size_t{ 1 } << 30)) {
+					break;
+				}
+				s.iterations *= 2;
+			}
+
+			if (s.skipped) {
+				std::printf("%-48s skipped: %s\n", bench.name, s.skipped);
+				continue;
+			}
+
+			std::printf("%-48s %14.1f %12zu", bench.name, seconds * 1e9 / static_cast<double>(s.iterations), s.iterations);
+			for (const auto& pair : s.counters) {
+				std::printf("  %s=%.6g", pair.first.c_str(), pair.second);
+			}
+			std::printf("\n");
+		}
+		return 0;
+	}
+}
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+
+/* Define and register a benchmark: BENCHMARK(name) { for (std::size_t i = 0; i < state.iterations; ++i) {...} } */
+#define BENCHMARK(name) \
+	static void name(bench::state& state); \
+	static bench::registration BENCH_CONCAT(name, _registration)(#name, name); \
+	static void name(bench::state& state)
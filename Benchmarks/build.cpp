@@ -0,0 +1,68 @@
+//
+// build.cpp
+//
+// Tree build time and memory footprint.
+//
+
+#include "bench.hpp"
+#include "settings.hpp"
+
+template<int Depth, int Fanout>
+static void build(bench::state& state) {
+	counting_resource counter;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		counter.allocations = 0;
+		counter.bytes = 0;
+		svh::scope<type_settings> root(&counter);
+		tree_builder<Depth, Fanout>::build(root);
+		bench::keep(root);
+	}
+
+	const double nodes = static_cast<double>(tree_builder<Depth, Fanout>::nodes());
+	state.counter("nodes", nodes);
+	state.counter("allocs/node", static_cast<double>(counter.allocations) / nodes);
+	state.counter("bytes/node", static_cast<double>(counter.bytes) / nodes);
+}
+
+BENCHMARK(build_depth2_fanout8) { build<2, 8>(state); }
+BENCHMARK(build_depth4_fanout8) { build<4, 8>(state); }
+BENCHMARK(build_depth8_fanout2) { build<8, 2>(state); }
+BENCHMARK(build_depth3_fanout32) { build<3, 32>(state); }
+
+BENCHMARK(build_realistic_64) {
+	counting_resource counter;
+	std::size_t scopes = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		counter.allocations = 0;
+		counter.bytes = 0;
+		svh::scope<type_settings> root(&counter);
+		scopes = realistic_tree<64>::build(root);
+		bench::keep(root);
+	}
+
+	state.counter("scopes", static_cast<double>(scopes));
+	state.counter("bytes/scope", static_cast<double>(counter.bytes) / static_cast<double>(scopes));
+}
+
+/* Resetting a scope that has a subtree of Fanout^Depth scopes below it */
+template<int Depth, int Fanout>
+static void push_default(bench::state& state) {
+	svh::scope<type_settings> root;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		auto& reset = root.push_default<tag<0>>();
+		tree_builder<Depth, Fanout>::build(reset);
+		reset.pop();
+	}
+	bench::keep(root);
+	state.counter("nodes", static_cast<double>(tree_builder<Depth, Fanout>::nodes() + 1));
+}
+
+BENCHMARK(push_default_leaf) {
+	svh::scope<type_settings> root;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		root.push_default<int>().max(static_cast<int>(i)).pop();
+	}
+	bench::keep(root);
+}
+
+BENCHMARK(push_default_rebuild_depth2_fanout8) { push_default<2, 8>(state); }
@@ -0,0 +1,59 @@
+//
+// children.cpp
+//
+// Lookup of existing children in scopes with 1, 8, 64 and 1024 of them, by type and by member.
+// Type children stop at 64, since every distinct type instantiates the scope templates again.
+//
+
+#include <utility>
+
+#include "bench.hpp"
+#include "settings.hpp"
+
+template<int N>
+struct many_members {
+	int values[N];
+};
+
+/* Push every tag<I> into one scope, then look each of them up again through push, which only consults children */
+template<int... I>
+static void children_find(bench::state& state, std::integer_sequence<int, I...>) {
+	svh::scope<type_settings> root;
+	(root.push<tag<I>>().max(I), ...);
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		((sum += root.push<tag<I>>().get_max()), ...);
+	}
+	bench::keep(sum);
+	state.counter("children", sizeof...(I));
+}
+
+/* Same with member children, looked up through the runtime member path */
+template<int N>
+static void member_children_find(bench::state& state) {
+	svh::scope<type_settings> root;
+	many_members<N> instance{};
+	auto& settings = root.push<many_members<N>>();
+	for (int& value : instance.values) {
+		settings.get_member(instance, value).max(1);
+	}
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		for (const int& value : instance.values) {
+			sum += settings.get_member(instance, value).get_max();
+		}
+	}
+	bench::keep(sum);
+	state.counter("children", N);
+}
+
+BENCHMARK(children_find_1) { children_find(state, std::make_integer_sequence<int, 1>{}); }
+BENCHMARK(children_find_8) { children_find(state, std::make_integer_sequence<int, 8>{}); }
+BENCHMARK(children_find_64) { children_find(state, std::make_integer_sequence<int, 64>{}); }
+
+BENCHMARK(member_children_find_1) { member_children_find<1>(state); }
+BENCHMARK(member_children_find_8) { member_children_find<8>(state); }
+BENCHMARK(member_children_find_64) { member_children_find<64>(state); }
+BENCHMARK(member_children_find_1024) { member_children_find<1024>(state); }
@@ -0,0 +1,72 @@
+//
+// concurrency.cpp
+//
+// Read throughput of one shared tree from 1 to 32 threads, frozen snapshot vs. live tree under SVH_THREAD_SAFE.
+//
+
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "settings.hpp"
+
+static constexpr std::size_t lookups_per_thread = 1 << 16;
+
+/* Every thread resolves the leaves of a depth 3, fanout 8 tree */
+template<class Tree>
+static void read_leaves(const Tree& tree, std::size_t& sink) {
+	for (std::size_t i = 0; i < lookups_per_thread; i += 4) {
+		sink += tree.template get<tag<1>, tag<2>, tag<3>>().get_max();
+		sink += tree.template get<tag<7>, tag<0>>().get_max();
+		sink += tree.template get<tag<4>, tag<4>, tag<4>>().get_max();
+		sink += tree.template get<tag<5>>().get_max();
+	}
+}
+
+template<class Tree>
+static void run_threads(bench::state& state, const Tree& tree, int thread_count) {
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		std::vector<std::thread> threads;
+		std::vector<std::size_t> sinks(thread_count);
+		for (int t = 0; t < thread_count; ++t) {
+			threads.emplace_back([&tree, &sinks, t] { read_leaves(tree, sinks[t]); });
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		bench::keep(sinks);
+	}
+	state.counter("threads", thread_count);
+	state.counter("lookups_per_iter", static_cast<double>(lookups_per_thread * thread_count));
+}
+
+static void concurrent_frozen(bench::state& state, int thread_count) {
+	svh::scope<type_settings> root;
+	tree_builder<3, 8>::build(root);
+	const auto frozen = root.freeze();
+	run_threads(state, frozen, thread_count);
+}
+
+static void concurrent_locked(bench::state& state, int thread_count) {
+	if (!SVH_THREAD_SAFE) {
+		state.skip("build with SVH_THREAD_SAFE=true");
+		return;
+	}
+	svh::scope<type_settings> root;
+	tree_builder<3, 8>::build(root);
+	run_threads(state, static_cast<const svh::scope<type_settings>&>(root), thread_count);
+}
+
+BENCHMARK(concurrent_frozen_threads1) { concurrent_frozen(state, 1); }
+BENCHMARK(concurrent_frozen_threads2) { concurrent_frozen(state, 2); }
+BENCHMARK(concurrent_frozen_threads4) { concurrent_frozen(state, 4); }
+BENCHMARK(concurrent_frozen_threads8) { concurrent_frozen(state, 8); }
+BENCHMARK(concurrent_frozen_threads16) { concurrent_frozen(state, 16); }
+BENCHMARK(concurrent_frozen_threads32) { concurrent_frozen(state, 32); }
+
+BENCHMARK(concurrent_locked_threads1) { concurrent_locked(state, 1); }
+BENCHMARK(concurrent_locked_threads2) { concurrent_locked(state, 2); }
+BENCHMARK(concurrent_locked_threads4) { concurrent_locked(state, 4); }
+BENCHMARK(concurrent_locked_threads8) { concurrent_locked(state, 8); }
+BENCHMARK(concurrent_locked_threads16) { concurrent_locked(state, 16); }
+BENCHMARK(concurrent_locked_threads32) { concurrent_locked(state, 32); }
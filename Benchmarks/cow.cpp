@@ -0,0 +1,41 @@
+//
+// cow.cpp
+//
+// Tree build with large settings, copied by value vs. svh::cow.
+//
+
+#include <vector>
+
+#include "bench.hpp"
+#include "settings.hpp"
+
+/* Several KB of settings copied into every pushed scope */
+template<class T, class Enable = void>
+struct copied_settings : svh::scope<copied_settings> {
+	std::vector<int> _table = std::vector<int>(1024);
+	int _max = 0;
+
+	copied_settings& max(const int& v) { _max = v; return *this; }
+};
+
+/* Same settings, shared until written */
+template<class T, class Enable = void>
+struct shared_settings : svh::scope<shared_settings> {
+	svh::cow<std::vector<int>> _table = std::vector<int>(1024);
+	int _max = 0;
+
+	shared_settings& max(const int& v) { _max = v; return *this; }
+};
+
+template<template<class> class Settings, int Depth, int Fanout>
+static void build_large(bench::state& state) {
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		svh::scope<Settings> root;
+		tree_builder<Depth, Fanout>::build(root);
+		bench::keep(root);
+	}
+	state.counter("nodes", static_cast<double>(tree_builder<Depth, Fanout>::nodes()));
+}
+
+BENCHMARK(build_large_copied_depth4_fanout8) { build_large<copied_settings, 4, 8>(state); }
+BENCHMARK(build_large_cow_depth4_fanout8) { build_large<shared_settings, 4, 8>(state); }
@@ -0,0 +1,102 @@
+//
+// debug_log.cpp
+//
+// Printing whole trees with debug_log, written to a discarding stream buffer, and with dump into a caller's buffer.
+//
+
+#include <iostream>
+#include <streambuf>
+#include <vector>
+
+#include "bench.hpp"
+#include "settings.hpp"
+
+/* Counts and drops everything written to it */
+struct null_buffer : std::streambuf {
+	std::size_t bytes = 0;
+
+	int overflow(int c) override {
+		++bytes;
+		return c;
+	}
+	std::streamsize xsputn(const char*, std::streamsize count) override {
+		bytes += static_cast<std::size_t>(count);
+		return count;
+	}
+};
+
+template<class Build>
+static void debug_log(bench::state& state, Build build) {
+	svh::scope<type_settings> root;
+	const std::size_t scopes = build(root);
+
+	null_buffer sink;
+	std::streambuf* previous = std::cout.rdbuf(&sink);
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		root.debug_log();
+	}
+	std::cout.rdbuf(previous);
+
+	state.counter("scopes", static_cast<double>(scopes));
+	state.counter("bytes", static_cast<double>(sink.bytes / state.iterations));
+}
+
+BENCHMARK(debug_log_depth3_fanout8) {
+	debug_log(state, [](svh::scope<type_settings>& root) {
+		tree_builder<3, 8>::build(root);
+		return tree_builder<3, 8>::nodes();
+	});
+}
+
+BENCHMARK(debug_log_realistic_64) {
+	debug_log(state, [](svh::scope<type_settings>& root) {
+		return realistic_tree<64>::build(root);
+	});
+}
+
+/* Into a buffer that holds the whole text */
+template<class Build>
+static void dump(bench::state& state, Build build, const svh::dump_options& options = {}) {
+	svh::scope<type_settings> root;
+	const std::size_t scopes = build(root);
+
+	std::vector<char> buffer(root.dump(nullptr, 0, options) + 1);
+	std::size_t bytes = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		bytes = root.dump(buffer.data(), buffer.size(), options);
+		bench::keep(buffer.data());
+	}
+
+	state.counter("scopes", static_cast<double>(scopes));
+	state.counter("bytes", static_cast<double>(bytes));
+}
+
+BENCHMARK(dump_realistic_64) {
+	dump(state, [](svh::scope<type_settings>& root) {
+		return realistic_tree<64>::build(root);
+	});
+}
+
+/* About 50k scopes */
+BENCHMARK(dump_depth4_fanout15) {
+	dump(state, [](svh::scope<type_settings>& root) {
+		tree_builder<4, 15>::build(root);
+		return tree_builder<4, 15>::nodes();
+	});
+}
+
+BENCHMARK(dump_depth4_fanout15_depth2) {
+	svh::dump_options options;
+	options.max_depth = 2;
+	dump(state, [](svh::scope<type_settings>& root) {
+		tree_builder<4, 15>::build(root);
+		return tree_builder<4, 15>::nodes();
+	}, options);
+}
+
+BENCHMARK(debug_log_depth4_fanout15) {
+	debug_log(state, [](svh::scope<type_settings>& root) {
+		tree_builder<4, 15>::build(root);
+		return tree_builder<4, 15>::nodes();
+	});
+}
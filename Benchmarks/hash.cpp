@@ -0,0 +1,128 @@
+//
+// hash.cpp
+//
+// Quality and lookup cost of member key hashes over reflection-style layouts:
+// many structs with hundreds of members sharing a handful of types.
+//
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "bench.hpp"
+#include "settings.hpp"
+
+struct member_key {
+	svh::type_id struct_type;
+	svh::type_id member_type;
+	std::size_t offset;
+
+	bool operator==(const member_key& other) const {
+		return struct_type == other.struct_type && member_type == other.member_type && offset == other.offset;
+	}
+};
+
+/* The previous member_key_hash */
+struct xor_member_hash {
+	std::size_t operator()(const member_key& k) const {
+		const std::uint64_t types = (static_cast<std::uint64_t>(k.struct_type.value) << 32) | k.member_type.value;
+		return std::hash<std::uint64_t>()(types) ^ std::hash<std::size_t>()(k.offset);
+	}
+};
+
+struct mixed_member_hash {
+	std::size_t operator()(const member_key& k) const {
+		return svh::member_hash{}(k.struct_type, k.member_type, k.offset);
+	}
+};
+
+/* 64 structs of 256 members each, cycling through 8 member types with naturally aligned offsets */
+static std::vector<member_key> layout_keys() {
+	static const std::size_t sizes[] = { 4, 4, 8, 8, 1, 4, 32, 16 };
+	std::vector<member_key> keys;
+	for (std::uint32_t s = 0; s < 64; ++s) {
+		std::size_t offset = 0;
+		for (std::uint32_t m = 0; m < 256; ++m) {
+			const std::uint32_t type = m % 8;
+			offset = (offset + sizes[type] - 1) / sizes[type] * sizes[type];
+			keys.push_back({ svh::type_id{ 100 + s }, svh::type_id{ type }, offset });
+			offset += sizes[type];
+		}
+	}
+	return keys;
+}
+
+template<class Hash>
+static void member_hash_quality(bench::state& state) {
+	const std::vector<member_key> keys = layout_keys();
+	std::unordered_map<member_key, int, Hash> map(keys.size());
+	for (const auto& key : keys) {
+		map.emplace(key, 0);
+	}
+
+	std::vector<member_key> lookups = keys;
+	std::shuffle(lookups.begin(), lookups.end(), std::mt19937(42));
+	std::size_t found = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		for (const auto& key : lookups) {
+			found += map.count(key);
+		}
+	}
+	bench::keep(found);
+
+	/* Keys with the same full hash collide in any table */
+	std::unordered_set<std::size_t> distinct;
+	for (const auto& key : keys) {
+		distinct.insert(Hash{}(key));
+	}
+
+	/* Chains when buckets are picked by the low bits, as power of two tables (e.g. MSVC's) do */
+	std::size_t mask = 1;
+	while (mask < keys.size()) {
+		mask <<= 1;
+	}
+	std::vector<std::size_t> chains(mask--);
+	for (const auto& key : keys) {
+		++chains[Hash{}(key) & mask];
+	}
+
+	/* Expected probes for a successful lookup, averaged over keys */
+	std::size_t longest = 0;
+	double probes = 0.0;
+	for (std::size_t length : chains) {
+		longest = std::max(longest, length);
+		probes += static_cast<double>(length) * static_cast<double>(length + 1) / 2.0;
+	}
+	state.counter("keys", static_cast<double>(keys.size()));
+	state.counter("equal_hashes", static_cast<double>(keys.size() - distinct.size()));
+	state.counter("pow2_longest_chain", static_cast<double>(longest));
+	state.counter("pow2_avg_probes", probes / static_cast<double>(keys.size()));
+}
+
+BENCHMARK(member_hash_xor) { member_hash_quality<xor_member_hash>(state); }
+BENCHMARK(member_hash_mixed) { member_hash_quality<mixed_member_hash>(state); }
+
+/* Same layout through a scope, via runtime member lookups */
+struct wide {
+	int values[256];
+};
+
+BENCHMARK(member_lookup_runtime_256) {
+	svh::scope<type_settings> root;
+	wide instance{};
+	auto& settings = root.push<wide>();
+	for (int& value : instance.values) {
+		settings.get_member(instance, value).max(1);
+	}
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		for (const int& value : instance.values) {
+			sum += settings.get_member(instance, value).get_max();
+		}
+	}
+	bench::keep(sum);
+	state.counter("members", 256);
+}
@@ -0,0 +1,116 @@
+//
+// load.cpp
+//
+// Getting a saved tree ready for lookups: rebuilding it in code against mapping a file written by save_binary,
+// and saving and loading it as JSON.
+//
+
+#include <filesystem>
+#include <sstream>
+
+#include "bench.hpp"
+#include "settings.hpp"
+#include "scope_binary.hpp"
+#include "scope_json.hpp"
+
+namespace {
+	const std::string& realistic_file() {
+		static const std::string path = [] {
+			const std::string file = (std::filesystem::temp_directory_path() / "svh_bench_realistic_64.bin").string();
+			svh::scope<type_settings> root;
+			realistic_tree<64>::build(root);
+			svh::save_binary(root, file);
+			return file;
+		}();
+		return path;
+	}
+
+	template<int... I>
+	void add_tags(svh::json_registry<type_settings>& registry, std::integer_sequence<int, I...>) {
+		(registry.add<tag<I>>("tag" + std::to_string(I)), ...);
+	}
+
+	const svh::json_registry<type_settings>& realistic_names() {
+		static const svh::json_registry<type_settings> registry = [] {
+			svh::json_registry<type_settings> names;
+			names.add<int>("int").add<float>("float").add<bool>("bool");
+			names.add<transform>("transform").add<health>("health").add<render>("render");
+			names.add_member<&transform::x>("transform.x").add_member<&transform::scale>("transform.scale");
+			names.add_member<&health::current>("health.current").add_member<&health::max>("health.max");
+			names.add_member<&render::layer>("render.layer");
+			add_tags(names, std::make_integer_sequence<int, 64>{});
+			return names;
+		}();
+		return registry;
+	}
+}
+
+/* Build and freeze, the fastest way to a read-only tree without a file */
+BENCHMARK(load_rebuild_realistic_64) {
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		svh::scope<type_settings> root;
+		realistic_tree<64>::build(root);
+		auto frozen = root.freeze();
+		bench::keep(frozen.get<tag<63>, transform>().get_max());
+	}
+}
+
+BENCHMARK(load_save_realistic_64) {
+	svh::scope<type_settings> root;
+	realistic_tree<64>::build(root);
+	const auto frozen = root.freeze();
+	std::size_t bytes = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		std::ostringstream out;
+		svh::save_binary(frozen, out);
+		bytes = out.str().size();
+		bench::keep(bytes);
+	}
+	state.counter("bytes", static_cast<double>(bytes));
+}
+
+/* Map, validate and do the first lookup */
+BENCHMARK(load_mapped_realistic_64) {
+	const std::string& path = realistic_file();
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		const svh::mapped_tree<type_settings> mapped(path);
+		bench::keep(mapped.get<tag<63>, transform>().get<&type_settings<transform>::_max>());
+	}
+}
+
+BENCHMARK(lookup_mapped_realistic_64) {
+	const svh::mapped_tree<type_settings> mapped(realistic_file());
+	const auto entity = mapped.at<tag<63>>();
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		bench::keep(entity.get<transform>().get<&type_settings<transform>::_max>());
+	}
+}
+
+BENCHMARK(save_json_realistic_64) {
+	svh::scope<type_settings> root;
+	realistic_tree<64>::build(root);
+	std::size_t bytes = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		std::ostringstream out;
+		svh::save_json(root, realistic_names(), out);
+		bytes = out.str().size();
+		bench::keep(bytes);
+	}
+	state.counter("bytes", static_cast<double>(bytes));
+}
+
+BENCHMARK(load_json_realistic_64) {
+	svh::scope<type_settings> source;
+	realistic_tree<64>::build(source);
+	std::ostringstream out;
+	svh::save_json(source, realistic_names(), out);
+	const std::string text = out.str();
+
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		svh::scope<type_settings> root;
+		std::istringstream in(text);
+		svh::load_json(root, realistic_names(), in);
+		bench::keep(root);
+	}
+	state.counter("bytes", static_cast<double>(text.size()));
+}
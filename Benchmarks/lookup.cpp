@@ -0,0 +1,182 @@
+//
+// lookup.cpp
+//
+// get<T>() hits at different distances, and resolving several types one by one and batched.
+//
+
+#include "bench.hpp"
+#include "settings.hpp"
+
+/* int resolved in the scope itself, in its parent, or at the root Depth levels up */
+template<int Depth>
+static svh::scope<type_settings>& chain(svh::scope<type_settings>& root) {
+	if constexpr (Depth == 0) {
+		return root;
+	} else {
+		return chain<Depth - 1>(root).template push<tag<Depth>>();
+	}
+}
+
+static void lookup_get(bench::state& state, svh::scope<type_settings>& from) {
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		sum += from.get<int>().get_max();
+	}
+	bench::keep(sum);
+}
+
+BENCHMARK(lookup_get_self) {
+	svh::scope<type_settings> root;
+	auto& nested = chain<8>(root);
+	nested.push<int>().max(1).pop();
+	lookup_get(state, nested);
+}
+
+BENCHMARK(lookup_get_parent) {
+	svh::scope<type_settings> root;
+	auto& nested = chain<8>(root);
+	nested.pop().push<int>().max(1).pop();
+	lookup_get(state, nested);
+}
+
+BENCHMARK(lookup_get_root_depth8) {
+	svh::scope<type_settings> root;
+	root.push<int>().max(1).pop();
+	lookup_get(state, chain<8>(root));
+}
+
+/* Same as lookup_get_root_depth8 on a tree that is edited between lookups, so every lookup resolves anew */
+BENCHMARK(lookup_get_root_depth8_uncached) {
+	svh::scope<type_settings> root;
+	root.push<int>().max(1).pop();
+	auto& nested = chain<8>(root);
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		root.push_default<double>();
+		sum += nested.get<int>().get_max();
+	}
+	bench::keep(sum);
+}
+
+/* Paths as deep as those generated from nested reflected structs */
+BENCHMARK(lookup_get_root_depth40_uncached) {
+	svh::scope<type_settings> root;
+	root.push<int>().max(1).pop();
+	auto& nested = chain<40>(root);
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		root.push_default<double>();
+		sum += nested.get<int>().get_max();
+	}
+	bench::keep(sum);
+}
+
+BENCHMARK(lookup_pop_to_root_depth40) {
+	svh::scope<type_settings> root;
+	auto& nested = chain<40>(root);
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		bench::keep(nested);
+		sum += reinterpret_cast<std::uintptr_t>(&nested.pop_to_root());
+	}
+	bench::keep(sum);
+}
+
+BENCHMARK(lookup_pop_depth40) {
+	svh::scope<type_settings> root;
+	auto& nested = chain<40>(root);
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		bench::keep(nested);
+		sum += reinterpret_cast<std::uintptr_t>(&nested.pop(40));
+	}
+	bench::keep(sum);
+}
+
+/* Lookups from inside the entities of an application shaped tree */
+BENCHMARK(lookup_get_realistic_64) {
+	svh::scope<type_settings> root;
+	state.counter("scopes", static_cast<double>(realistic_tree<64>::build(root)));
+	auto& transform_settings = root.get<tag<13>>().get<transform>();
+	auto& health_settings = root.get<tag<40>>().get<health>();
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		sum += transform_settings.get<float>().get_max();
+		sum += transform_settings.get_member<&transform::x>().get_max();
+		sum += health_settings.get_member<&health::current>().get_max();
+		sum += health_settings.get<int>().get_max();
+	}
+	bench::keep(sum);
+}
+
+/* Four types set at the root, looked up from eight levels down */
+static svh::scope<type_settings>& lookup_tree(svh::scope<type_settings>& root) {
+	root.push<int>().max(1).pop()
+		.push<float>().max(2).pop()
+		.push<bool>().max(3).pop()
+		.push<double>().max(4).pop();
+	return root.push<tag<0>, tag<1>, tag<2>, tag<3>, tag<4>, tag<5>, tag<6>, tag<7>>();
+}
+
+BENCHMARK(lookup_get_separate_4) {
+	svh::scope<type_settings> root;
+	auto& nested = lookup_tree(root);
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		sum += nested.get<int>().get_max();
+		sum += nested.get<float>().get_max();
+		sum += nested.get<bool>().get_max();
+		sum += nested.get<double>().get_max();
+	}
+	bench::keep(sum);
+	state.counter("types", 4);
+}
+
+BENCHMARK(lookup_get_all_4) {
+	svh::scope<type_settings> root;
+	auto& nested = lookup_tree(root);
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		const auto [i32, f32, b, f64] = nested.get_all<int, float, bool, double>();
+		sum += i32.get_max() + f32.get_max() + b.get_max() + f64.get_max();
+	}
+	bench::keep(sum);
+	state.counter("types", 4);
+}
+
+/* Probing for settings that are not there, with try_get and by catching the error of get */
+BENCHMARK(lookup_probe_missing_try_get) {
+	svh::scope<type_settings> root;
+	const auto& nested = chain<8>(root);
+
+	std::size_t found = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		found += nested.try_get<int>().has_value();
+	}
+	bench::keep(found);
+}
+
+BENCHMARK(lookup_probe_missing_catch) {
+#if SVH_EXCEPTIONS
+	svh::scope<type_settings> root;
+	const auto& nested = chain<8>(root);
+
+	std::size_t found = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		try {
+			found += nested.get<int>().get_max() != 0;
+		} catch (const std::runtime_error&) {
+		}
+	}
+	bench::keep(found);
+#else
+	state.skip("built without exceptions");
+#endif
+}
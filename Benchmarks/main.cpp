@@ -0,0 +1,11 @@
+//
+// main.cpp
+//
+// Usage: Benchmarks [filter]
+//
+
+#include "bench.hpp"
+
+int main(int argc, char** argv) {
+	return bench::run_all(argc > 1 ? argv[1] : nullptr);
+}
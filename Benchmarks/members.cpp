@@ -0,0 +1,102 @@
+//
+// members.cpp
+//
+// Member settings lookups through compile-time member pointers.
+//
+
+#include "bench.hpp"
+#include "settings.hpp"
+
+struct vertex {
+	float x, y, z;
+	int id;
+	float u, v;
+	int flags;
+	double weight;
+};
+
+/* Settings for every member of vertex, looked up from a nested scope so lookups also fall back to parents */
+static svh::scope<type_settings>& vertex_tree(svh::scope<type_settings>& root) {
+	auto& settings = root.push<vertex>();
+	settings.push_member<&vertex::id>().max(1).pop()
+		.push_member<&vertex::flags>().max(2).pop()
+		.push<float>().max(3).pop()
+		.push<double>().max(4).pop();
+	return settings.push<tag<0>>();
+}
+
+BENCHMARK(member_get_static_8) {
+	svh::scope<type_settings> root;
+	auto& nested = vertex_tree(root);
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		sum += nested.get_member<&vertex::x>().get_max();
+		sum += nested.get_member<&vertex::y>().get_max();
+		sum += nested.get_member<&vertex::z>().get_max();
+		sum += nested.get_member<&vertex::id>().get_max();
+		sum += nested.get_member<&vertex::u>().get_max();
+		sum += nested.get_member<&vertex::v>().get_max();
+		sum += nested.get_member<&vertex::flags>().get_max();
+		sum += nested.get_member<&vertex::weight>().get_max();
+	}
+	bench::keep(sum);
+	state.counter("members", 8);
+}
+
+BENCHMARK(member_get_runtime_8) {
+	svh::scope<type_settings> root;
+	auto& nested = vertex_tree(root);
+	const vertex instance{};
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		sum += nested.get_member(instance, instance.x).get_max();
+		sum += nested.get_member(instance, instance.y).get_max();
+		sum += nested.get_member(instance, instance.z).get_max();
+		sum += nested.get_member(instance, instance.id).get_max();
+		sum += nested.get_member(instance, instance.u).get_max();
+		sum += nested.get_member(instance, instance.v).get_max();
+		sum += nested.get_member(instance, instance.flags).get_max();
+		sum += nested.get_member(instance, instance.weight).get_max();
+	}
+	bench::keep(sum);
+	state.counter("members", 8);
+}
+
+BENCHMARK(member_get_bulk_8) {
+	svh::scope<type_settings> root;
+	auto& nested = vertex_tree(root);
+	const vertex instance{};
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		const auto [x, y, z, id, u, v, flags, weight] = nested.get_members(instance,
+			instance.x, instance.y, instance.z, instance.id, instance.u, instance.v, instance.flags, instance.weight);
+		sum += x.get_max() + y.get_max() + z.get_max() + id.get_max();
+		sum += u.get_max() + v.get_max() + flags.get_max() + weight.get_max();
+	}
+	bench::keep(sum);
+	state.counter("members", 8);
+}
+
+/* Const lookups only, without the auto insert fallback of get_member */
+BENCHMARK(member_find_runtime_8) {
+	svh::scope<type_settings> root;
+	const auto& nested = vertex_tree(root);
+	const vertex instance{};
+
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		sum += nested.find_member_runtime(instance, instance.x)->get_max();
+		sum += nested.find_member_runtime(instance, instance.y)->get_max();
+		sum += nested.find_member_runtime(instance, instance.z)->get_max();
+		sum += nested.find_member_runtime(instance, instance.id)->get_max();
+		sum += nested.find_member_runtime(instance, instance.u)->get_max();
+		sum += nested.find_member_runtime(instance, instance.v)->get_max();
+		sum += nested.find_member_runtime(instance, instance.flags)->get_max();
+		sum += nested.find_member_runtime(instance, instance.weight)->get_max();
+	}
+	bench::keep(sum);
+	state.counter("members", 8);
+}
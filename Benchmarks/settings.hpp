@@ -0,0 +1,163 @@
+//
+// settings.hpp
+//
+// Settings types and synthetic tree generators shared by the benchmarks.
+//
+
+#pragma once
+
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+#include "scope.hpp"
+
+template<class T, class Enable = void>
+struct type_settings : svh::scope<type_settings> {
+	int _min = std::numeric_limits<int>::min();
+	int _max = std::numeric_limits<int>::max();
+	std::string _label = "default";
+
+	type_settings& min(const int& v) { _min = v; return *this; }
+	type_settings& max(const int& v) { _max = v; return *this; }
+	type_settings& label(const std::string& v) { _label = v; return *this; }
+
+	const int& get_min() const { return _min; }
+	const int& get_max() const { return _max; }
+};
+
+/* Bounds are saved by save_binary, the label is not trivially copyable */
+template<class T>
+struct svh::reflect<type_settings<T>> {
+	static constexpr auto fields = std::make_tuple(svh::field("min", &type_settings<T>::_min), svh::field("max", &type_settings<T>::_max));
+};
+
+/* Distinct types to fan out over */
+template<int N>
+struct tag {};
+
+/* Counts what goes through it, to report the footprint of a tree */
+struct counting_resource : std::pmr::memory_resource {
+	std::pmr::memory_resource* upstream = std::pmr::new_delete_resource();
+	std::size_t allocations = 0;
+	std::size_t bytes = 0;
+
+	void* do_allocate(std::size_t size, std::size_t alignment) override {
+		++allocations;
+		bytes += size;
+		return upstream->allocate(size, alignment);
+	}
+	void do_deallocate(void* p, std::size_t size, std::size_t alignment) override {
+		upstream->deallocate(p, size, alignment);
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+};
+
+/* Push tag<0>..tag<Fanout - 1> under a scope, recursing Depth levels: Fanout^1 + ... + Fanout^Depth scopes */
+template<int Depth, int Fanout>
+struct tree_builder {
+	template<class Scope>
+	static void build(Scope& s) {
+		level(s, std::make_integer_sequence<int, Fanout>{});
+	}
+
+	template<class Scope, int... I>
+	static void level(Scope& s, std::integer_sequence<int, I...>) {
+		(child<I>(s), ...);
+	}
+
+	template<int I, class Scope>
+	static void child(Scope& s) {
+		auto& pushed = s.template push<tag<I>>();
+		pushed.max(I);
+		if constexpr (Depth > 1) {
+			tree_builder<Depth - 1, Fanout>::build(pushed);
+		}
+		pushed.pop();
+	}
+
+	static constexpr std::size_t nodes() {
+		std::size_t total = 0;
+		std::size_t count = 1;
+		for (int level = 0; level < Depth; ++level) {
+			count *= Fanout;
+			total += count;
+		}
+		return total;
+	}
+};
+
+/* Components of the entities in realistic_tree */
+struct transform {
+	float x, y, z;
+	float scale;
+};
+
+struct health {
+	int current, max;
+	float regen;
+};
+
+struct render {
+	int layer;
+	bool visible;
+	float alpha;
+};
+
+/*
+Shaped like an application's configuration: defaults for the primitives at the root,
+component structs with member overrides, and Entities subtrees (tag<0>..tag<Entities - 1>)
+that override some components again. Returns the number of scopes pushed.
+*/
+template<int Entities>
+struct realistic_tree {
+	template<class Scope>
+	static std::size_t build(Scope& root) {
+		root.template push<int>().min(0).max(100).pop()
+			.template push<float>().min(-1).max(1).pop()
+			.template push<bool>().pop()
+			.template push<transform>()
+			____.template push_member<&transform::scale>().min(0).pop()
+			.pop()
+			.template push<health>()
+			____.template push_member<&health::current>().max(1000).pop()
+			____.template push_member<&health::max>().max(1000).pop()
+			.pop()
+			.template push<render>()
+			____.template push_member<&render::layer>().max(16).pop()
+			.pop();
+		return 10 + entities(root, std::make_integer_sequence<int, Entities>{});
+	}
+
+	template<class Scope, int... I>
+	static std::size_t entities(Scope& root, std::integer_sequence<int, I...>) {
+		return (entity<I>(root) + ... + 0);
+	}
+
+	/* Every entity overrides its transform, every second one its health, every fourth one its render layer */
+	template<int I, class Scope>
+	static std::size_t entity(Scope& root) {
+		auto& node = root.template push<tag<I>>();
+		std::size_t pushed = 3;
+		node.template push<transform>()
+			____.template push_member<&transform::x>().max(I).pop()
+			.pop();
+		if constexpr (I % 2 == 0) {
+			node.template push<health>()
+				____.template push_member<&health::max>().max(I).pop()
+				.pop();
+			pushed += 2;
+		}
+		if constexpr (I % 4 == 0) {
+			node.template push<render>()
+				____.template push_member<&render::layer>().max(I % 16).pop()
+				.pop();
+			pushed += 2;
+		}
+		node.pop();
+		return pushed;
+	}
+};
@@ -0,0 +1,55 @@
+//
+// sparse.cpp
+//
+// Memory of a tree whose scopes override one field, full copies vs. svh::sparse_fields.
+//
+
+#include <string>
+
+#include "bench.hpp"
+#include "settings.hpp"
+
+/* Every pushed scope stores all eight fields */
+template<class T, class Enable = void>
+struct full_settings : svh::scope<full_settings> {
+	int _min = 0;
+	int _max = 100;
+	int _step = 1;
+	int _precision = 2;
+	std::string _label = "value";
+	std::string _tooltip = "tooltip";
+	std::string _unit = "unit";
+	std::string _format = "%d";
+
+	full_settings& max(const int& v) { _max = v; return *this; }
+};
+
+/* Every pushed scope stores the fields it sets */
+template<class T, class Enable = void>
+struct delta_settings : svh::scope<delta_settings>, svh::sparse_fields<int, int, int, int, std::string, std::string, std::string, std::string> {
+	enum { min_field, max_field, step_field, precision_field, label_field, tooltip_field, unit_field, format_field };
+
+	delta_settings() : sparse_fields(0, 100, 1, 2, "value", "tooltip", "unit", "%d") {}
+
+	delta_settings& max(const int& v) { set_field<max_field>(v); return *this; }
+};
+
+template<template<class> class Settings, int Depth, int Fanout>
+static void sparse_build(bench::state& state) {
+	std::size_t bytes = 0;
+	for (std::size_t i = 0; i < state.iterations; ++i) {
+		counting_resource resource;
+		{
+			svh::scope<Settings> root(&resource);
+			tree_builder<1, Fanout>::build(root); /* Defaults at the root, overrides below */
+			tree_builder<Depth, Fanout>::build(root);
+			bench::keep(root);
+		}
+		bytes = resource.bytes;
+	}
+	state.counter("bytes_per_node", static_cast<double>(bytes) / static_cast<double>(tree_builder<Depth, Fanout>::nodes()));
+	state.counter("settings_bytes", static_cast<double>(sizeof(Settings<int>) - sizeof(svh::scope<Settings>)));
+}
+
+BENCHMARK(sparse_full_copy_depth4_fanout8) { sparse_build<full_settings, 4, 8>(state); }
+BENCHMARK(sparse_delta_depth4_fanout8) { sparse_build<delta_settings, 4, 8>(state); }
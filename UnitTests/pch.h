@@ -6,5 +6,21 @@
 
 #include "gtest/gtest.h"
 
+#include <clocale>
+#include <filesystem>
+#include <list>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
 #define SVH_AUTO_INSERT true
-#include "scope.hpp"
\ No newline at end of file
+#include "scope.hpp"
+#include "scope_binary.hpp"
+#include "scope_json.hpp"
+
+/* Lookup failures throw std::runtime_error, or print and abort when built without exceptions */
+#if SVH_EXCEPTIONS
+#define EXPECT_SCOPE_ERROR(statement) EXPECT_THROW(statement, std::runtime_error)
+#else
+#define EXPECT_SCOPE_ERROR(statement) EXPECT_DEATH(statement, "svh: ")
+#endif
@@ -28,6 +28,17 @@ struct type_settings<float> : svh::scope<type_settings> {
 	const float& get_max() const { return _max; }
 };
 
+/* Fields saved by save_binary */
+template<>
+struct svh::reflect<type_settings<int>> {
+	static constexpr auto fields = std::make_tuple(svh::field("min", &type_settings<int>::_min), svh::field("max", &type_settings<int>::_max));
+};
+
+template<>
+struct svh::reflect<type_settings<float>> {
+	static constexpr auto fields = std::make_tuple(svh::field("min", &type_settings<float>::_min), svh::field("max", &type_settings<float>::_max));
+};
+
 TEST(Default, push_single) {
 	svh::scope<type_settings> root;
 	root.push<int>()
@@ -132,6 +143,52 @@ TEST(Default, pop_to_root) {
 	EXPECT_EQ(float_settings.get_max(), 50.0f);
 }
 
+TEST(Default, pop_count) {
+	std::pmr::monotonic_buffer_resource arena;
+	svh::scope<type_settings> root(&arena);
+	auto& nested = root.push<MyStruct, bool, float, int>();
+
+	auto& parent = root.get<MyStruct, bool, float>();
+	EXPECT_EQ(&nested.pop(), &parent);
+	EXPECT_EQ(&nested.pop(3), &root.get<MyStruct>());
+	EXPECT_EQ(&nested.pop(4), &root);
+	EXPECT_SCOPE_ERROR(nested.pop(5));
+	EXPECT_EQ(&nested.pop_to_root(), &root);
+	EXPECT_EQ(&root.pop_to_root(), &root);
+
+	svh::scope<type_settings> lazy;
+	EXPECT_EQ(&lazy.push<int>().pop_to_root(), &lazy);
+}
+
+TEST(Default, try_lookups) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.max(5)
+		.pop()
+		.push<MyStruct>()
+		.pop();
+
+	auto found = root.get<MyStruct>().try_get<int>();
+	ASSERT_TRUE(found);
+	EXPECT_EQ(found->get_max(), 5);
+	EXPECT_EQ(found.error(), svh::scope_error::none);
+
+	auto missing = root.try_get<float>();
+	EXPECT_FALSE(missing);
+	EXPECT_EQ(missing.get(), nullptr);
+	EXPECT_EQ(missing.error(), svh::scope_error::not_found);
+	EXPECT_EQ(root.find<float>(), nullptr); /* Probing did not insert */
+
+	auto nested = root.try_get<MyStruct, int>();
+	EXPECT_EQ(nested.get(), found.get());
+	EXPECT_EQ((root.try_get<bool, int>().error()), svh::scope_error::not_found);
+
+	auto pushed = root.try_push<MyStruct, float>();
+	ASSERT_TRUE(pushed);
+	EXPECT_EQ(pushed.get(), root.get<MyStruct>().find<float>());
+	EXPECT_SCOPE_ERROR(root.try_get<double>().value());
+}
+
 TEST(Default, push_nested) {
 	svh::scope<type_settings> root;
 	root.push<MyStruct>()
@@ -178,8 +235,8 @@ TEST(Default, default_fallback) {
 		EXPECT_EQ(float_settings.get_min(), std::numeric_limits<float>::min());
 		EXPECT_EQ(float_settings.get_max(), std::numeric_limits<float>::max());
 	} else {
-		EXPECT_THROW(root.get<int>(), std::runtime_error);
-		EXPECT_THROW(root.get<float>(), std::runtime_error);
+		EXPECT_SCOPE_ERROR(root.get<int>());
+		EXPECT_SCOPE_ERROR(root.get<float>());
 	}
 }
 
@@ -248,6 +305,21 @@ TEST(Default, push_default) {
 	EXPECT_EQ(mystruct_int_settings.get_max(), 20);
 }
 
+TEST(Default, push_default_existing) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.min(-50)
+		____.max(50)
+		.pop()
+		.push_default<int>()
+		____.max(20)
+		.pop();
+
+	auto& int_settings = root.get<int>();
+	EXPECT_EQ(int_settings.get_min(), std::numeric_limits<int>::min());
+	EXPECT_EQ(int_settings.get_max(), 20);
+}
+
 // Function parameter passing
 static void func(const svh::scope<type_settings>& s) {
 	auto& int_settings = s.get<int>();
@@ -353,7 +425,7 @@ TEST(Default, get_nonexistent) {
 		auto& mystruct_settings = root.get<MyStruct>();
 		EXPECT_TRUE(&mystruct_settings != nullptr);
 	} else {
-		EXPECT_THROW(root.get<MyStruct>(), std::runtime_error);
+		EXPECT_SCOPE_ERROR(root.get<MyStruct>());
 	}
 }
 
@@ -363,6 +435,39 @@ struct TestStruct {
 	int b;
 };
 
+TEST(Default, member_offset) {
+	struct Padded {
+		char c;
+		double d;
+		int i;
+	};
+	EXPECT_EQ(svh::get_member_offset<&TestStruct::a>(), offsetof(TestStruct, a));
+	EXPECT_EQ(svh::get_member_offset<&TestStruct::b>(), offsetof(TestStruct, b));
+	EXPECT_EQ(svh::get_member_offset<&Padded::d>(), offsetof(Padded, d));
+	EXPECT_EQ(svh::get_member_offset<&Padded::i>(), offsetof(Padded, i));
+}
+
+struct AbstractStruct {
+	virtual ~AbstractStruct() = default;
+	virtual void run() = 0;
+
+	int a = 0;
+	int b = 0;
+};
+
+TEST(Default, member_abstract) {
+	EXPECT_EQ(svh::get_member_offset<&AbstractStruct::b>() - svh::get_member_offset<&AbstractStruct::a>(), sizeof(int));
+
+	svh::scope<type_settings> root;
+	root.push<AbstractStruct>()
+		____.push_member<&AbstractStruct::b>()
+		________.max(5)
+		____.pop()
+		.pop();
+	EXPECT_EQ(root.get<AbstractStruct>().get_member<&AbstractStruct::b>().get_max(), 5);
+	EXPECT_EQ(root.find_member<&AbstractStruct::a>(), nullptr);
+}
+
 TEST(Default, member_variable) {
 	svh::scope<type_settings> root;
 	root.push<TestStruct>()
@@ -431,6 +536,86 @@ TEST(Default, member_fallback) {
 	EXPECT_EQ(a_settings.get_max(), 10);
 }
 
+TEST(Default, member_bulk) {
+	svh::scope<type_settings> root;
+	root.push<TestStruct>()
+		____.push<int>()
+		________.max(5)
+		____.pop()
+		____.push_member<&TestStruct::b>()
+		________.max(10)
+		____.pop()
+		.pop();
+
+	TestStruct instance{ 1, 2 };
+	auto& settings = root.get<TestStruct>();
+	auto [a_settings, b_settings] = settings.get_members(instance, instance.a, instance.b);
+	EXPECT_EQ(a_settings.get_max(), 5);
+	EXPECT_EQ(b_settings.get_max(), 10);
+	EXPECT_EQ(&b_settings, &settings.get_member<&TestStruct::b>());
+
+	auto [a_found, b_found] = settings.find_members(instance, instance.a, instance.b);
+	EXPECT_EQ(a_found, &a_settings);
+	EXPECT_EQ(b_found, &b_settings);
+}
+
+TEST(Default, get_all) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.max(50)
+		.pop()
+		.push<MyStruct>()
+		____.push<float>()
+		________.max(2.0f)
+		____.pop()
+		.pop();
+
+	auto& mystruct = root.get<MyStruct>();
+	auto [i, f] = mystruct.get_all<int, float>();
+	EXPECT_EQ(&i, &root.get<int>());
+	EXPECT_EQ(&f, &mystruct.get<float>());
+	EXPECT_FLOAT_EQ(f.get_max(), 2.0f);
+
+	auto [found_int, found_bool] = mystruct.find_all<int, bool>();
+	EXPECT_EQ(found_int, &i);
+	EXPECT_EQ(found_bool, nullptr);
+
+	if (SVH_AUTO_INSERT) {
+		auto [b, again] = mystruct.get_all<bool, int>();
+		EXPECT_EQ(&b, mystruct.find<bool>());
+		EXPECT_EQ(&again, &i);
+	}
+
+	/* Inside a member scope, resolution goes through the member like find does */
+	auto& member = root.push<TestStruct>().push_member<&TestStruct::a>();
+	auto [member_int, member_again] = member.find_all<int, int>();
+	EXPECT_EQ(member_int, member.find<int>());
+	EXPECT_EQ(member_again, member_int);
+
+	const auto& const_root = root;
+	EXPECT_SCOPE_ERROR(const_root.get_all<double>());
+}
+
+TEST(Default, try_get_member) {
+	svh::scope<type_settings> root;
+	root.push<TestStruct>()
+		____.push_member<&TestStruct::a>()
+		________.max(10)
+		____.pop()
+		.pop();
+
+	const auto& settings = root.get<TestStruct>();
+	EXPECT_EQ(settings.try_get_member<&TestStruct::a>()->get_max(), 10);
+	EXPECT_EQ(settings.try_get_member<&TestStruct::b>().error(), svh::scope_error::not_found);
+
+	TestStruct instance{ 1, 2 };
+	TestStruct other{ 3, 4 };
+	EXPECT_EQ(settings.try_get_member(instance, instance.a)->get_max(), 10);
+	EXPECT_EQ(settings.try_get_member(instance, instance.b).error(), svh::scope_error::not_found);
+	EXPECT_EQ(settings.try_get_member(instance, other.a).error(), svh::scope_error::out_of_bounds);
+	EXPECT_SCOPE_ERROR(settings.find_member_runtime(instance, other.a));
+}
+
 template<class T, class M>
 void do_something(const svh::scope<type_settings>& s, const T& instance, const M& member) {
 	auto& settings = s.get<TestStruct>().get_member(instance, member);
@@ -527,4 +712,1222 @@ TEST(Default, other_settings) {
 
 	auto& other_int_settings = other_root.get<int>();
 	EXPECT_EQ(other_int_settings.get_value(), 123);
-}
\ No newline at end of file
+}
+TEST(Default, type_id) {
+	const svh::type_id int_id = svh::type_id::of<int>();
+	EXPECT_EQ(int_id, svh::type_id::of<int>());
+	EXPECT_EQ(int_id, svh::type_id::of<const int&>());
+	EXPECT_NE(int_id, svh::type_id::of<float>());
+	EXPECT_EQ(int_id.type(), std::type_index(typeid(int)));
+	EXPECT_EQ(int_id.name(), "int");
+	EXPECT_EQ(int_id.hash(), svh::type_hash<int>());
+}
+
+struct renamed {};
+struct collides_a {};
+struct collides_b {};
+
+template<>
+struct svh::type_name<renamed> {
+	static constexpr std::string_view value = "app::renamed";
+};
+template<>
+struct svh::type_name<collides_a> {
+	static constexpr std::string_view value = "collides";
+};
+template<>
+struct svh::type_name<collides_b> {
+	static constexpr std::string_view value = "collides";
+};
+
+TEST(Default, type_names) {
+	static_assert(svh::type_name<MyStruct>::value == "MyStruct");
+	static_assert(svh::type_name<std::pair<int, float>>::value.find("pair<int,") != std::string_view::npos);
+	static_assert(svh::type_hash<int>() != svh::type_hash<unsigned int>());
+
+	EXPECT_EQ(svh::type_id::of<renamed>().name(), "app::renamed");
+	EXPECT_EQ(svh::type_id::of<renamed>().hash(), svh::detail::fnv1a("app::renamed"));
+
+	/* Types sharing a name work in memory, only saving them together is rejected */
+	svh::scope<type_settings> root;
+	root.push<collides_a>()
+		.pop()
+		.push<collides_b>()
+		.pop();
+	EXPECT_NE(svh::type_id::of<collides_a>(), svh::type_id::of<collides_b>());
+	EXPECT_NE(static_cast<const void*>(&root.get<collides_a>()), static_cast<const void*>(&root.get<collides_b>()));
+
+	std::ostringstream out;
+	EXPECT_SCOPE_ERROR(svh::save_binary(root, out));
+
+	svh::json_registry<type_settings> names;
+	names.add<collides_a>();
+	EXPECT_SCOPE_ERROR(names.add<collides_b>());
+}
+
+TEST(Default, dump) {
+	svh::scope<type_settings> root;
+	root.push<MyStruct>()
+		____.push<int>()
+		________.push<float>()
+		________.pop()
+		____.pop()
+		.pop()
+		.push<TestStruct>()
+		____.push_member<&TestStruct::b>()
+		____.pop()
+		.pop();
+
+	/* One scope per level, so the order does not depend on the hash maps */
+	char text[128];
+	const std::size_t length = root.get<MyStruct>().dump(text, sizeof(text));
+	EXPECT_STREQ(text, "int\n==float\n");
+	EXPECT_EQ(length, std::strlen(text));
+
+	svh::dump_options options;
+	options.max_depth = 1;
+	options.indent = 1;
+	options.margin = 2;
+	options.indent_char = ' ';
+	root.get<MyStruct>().dump(text, sizeof(text), options);
+	EXPECT_STREQ(text, "  int\n");
+
+	root.get<TestStruct>().dump(text, sizeof(text));
+	EXPECT_STREQ(text, "TestStruct::(offset 4) -> int\n");
+
+	/* Filtered scopes are skipped with their subtree */
+	root.dump(text, sizeof(text), {}, [](const svh::dump_entry& entry) { return entry.type != svh::type_id::of<MyStruct>(); });
+	EXPECT_STREQ(text, "TestStruct\n==TestStruct::(offset 4) -> int\n");
+
+	/* Cut to fit like snprintf */
+	char small[5];
+	EXPECT_EQ(root.get<MyStruct>().dump(small, sizeof(small)), length);
+	EXPECT_STREQ(small, "int\n");
+
+	std::ostringstream out;
+	root.get<MyStruct>().dump(out);
+	EXPECT_EQ(out.str(), "int\n==float\n");
+}
+
+/* Resolution cache tests */
+TEST(Cache, hit_after_miss) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.min(-50)
+		____.max(50)
+		.pop()
+		.push<MyStruct, bool, float>()
+		.pop(3);
+
+	auto& nested = root.get<MyStruct, bool, float>();
+	root.reset_cache_stats();
+
+	auto& first = nested.get<int>();
+	auto& second = nested.get<int>();
+	EXPECT_EQ(&first, &second);
+	EXPECT_EQ(&first, &root.get<int>());
+
+	if (SVH_RESOLVE_CACHE && !SVH_THREAD_SAFE) {
+		const auto stats = root.cache_stats();
+		EXPECT_EQ(stats.hits, 1u);
+		EXPECT_EQ(stats.misses, 2u); /* nested and root each resolve once */
+	}
+}
+
+TEST(Cache, invalidated_by_push) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.min(-50)
+		____.max(50)
+		.pop()
+		.push<MyStruct>()
+		.pop();
+
+	auto& mystruct = root.get<MyStruct>();
+	EXPECT_EQ(mystruct.get<int>().get_max(), 50);
+
+	/* Adding a closer scope must win over the cached root settings */
+	mystruct.push<int>()
+		____.max(20)
+		.pop();
+	root.reset_cache_stats();
+	EXPECT_EQ(mystruct.get<int>().get_max(), 20);
+	EXPECT_EQ(mystruct.get<int>().get_max(), 20);
+
+	if (SVH_RESOLVE_CACHE && !SVH_THREAD_SAFE) {
+		EXPECT_EQ(root.cache_stats().misses, 1u);
+		EXPECT_EQ(root.cache_stats().hits, 1u);
+		EXPECT_DOUBLE_EQ(root.cache_stats().hit_rate(), 0.5);
+	}
+}
+
+TEST(Cache, member_offsets) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.max(50)
+		.pop()
+		.push<TestStruct>()
+		.pop();
+
+	TestStruct instance{ 1, 2 };
+	auto& settings = root.get<TestStruct>();
+	EXPECT_EQ(settings.get_member(instance, instance.b).get_max(), 50);
+	root.reset_cache_stats();
+	EXPECT_EQ(settings.get_member(instance, instance.b).get_max(), 50);
+	if (SVH_RESOLVE_CACHE && !SVH_THREAD_SAFE) {
+		EXPECT_EQ(root.cache_stats().hits, 1u);
+		EXPECT_EQ(root.cache_stats().misses, 0u);
+	}
+
+	/* A member scope added later must win over the cached fallback */
+	settings.push_member<&TestStruct::b>()
+		____.max(10)
+		.pop();
+	EXPECT_EQ(settings.get_member(instance, instance.b).get_max(), 10);
+	EXPECT_EQ(settings.get_member(instance, instance.a).get_max(), 50);
+}
+
+/* Instrumentation tests, only recorded with SVH_INSTRUMENT */
+TEST(Instrument, counters) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		.pop()
+		.push<MyStruct>()
+		____.push<float>()
+		____.pop()
+		.pop();
+
+	auto& mystruct = root.get<MyStruct>();
+	auto& nested = mystruct.get<float>();
+	root.reset_lookup_stats();
+
+	EXPECT_NE(nested.find<int>(), nullptr);
+	EXPECT_NE(mystruct.find<int>(), nullptr);
+	EXPECT_NE(root.find<int>(), nullptr);
+	EXPECT_EQ(nested.find<bool>(), nullptr);
+	root.get<bool>();
+	mystruct.push<int>().pop();
+
+	const auto stats = root.lookup_stats();
+	if (!SVH_INSTRUMENT) {
+		EXPECT_EQ(stats.total.lookups(), 0u);
+		EXPECT_TRUE(stats.types.empty());
+		EXPECT_TRUE(stats.scopes.empty());
+		return;
+	}
+
+	EXPECT_EQ(stats.total.hits, 3u);
+	EXPECT_EQ(stats.total.misses, 2u); /* The recheck of get before inserting is not counted */
+	EXPECT_EQ(stats.total.fallback_depths[0], 1u);
+	EXPECT_EQ(stats.total.fallback_depths[1], 1u);
+	EXPECT_EQ(stats.total.fallback_depths[2], 1u);
+	EXPECT_EQ(stats.total.auto_inserts, 1u);
+	EXPECT_EQ(stats.total.push_copies, 1u);
+
+	ASSERT_FALSE(stats.types.empty());
+	EXPECT_EQ(stats.types[0].first, svh::type_id::of<int>());
+	EXPECT_EQ(stats.types[0].second.fallbacks(), 2u);
+	EXPECT_EQ(stats.types[0].second.push_copies, 1u);
+
+	const auto from_nested = std::find_if(stats.scopes.begin(), stats.scopes.end(), [&](const auto& entry) { return entry.origin == &nested; });
+	ASSERT_NE(from_nested, stats.scopes.end());
+	EXPECT_EQ(from_nested->type, svh::type_id::of<float>());
+	EXPECT_EQ(from_nested->counters.lookups(), 2u);
+	EXPECT_EQ(from_nested->counters.misses, 1u);
+
+	std::ostringstream out;
+	stats.print(out);
+	EXPECT_NE(out.str().find("  int: 1 local, 2 fallback, 0 missed, 1 push copies\n"), std::string::npos);
+
+	root.reset_lookup_stats();
+	EXPECT_EQ(root.lookup_stats().total.lookups(), 0u);
+}
+
+TEST(Instrument, member_lookups_not_counted) {
+	svh::scope<type_settings> root;
+	root.push<TestStruct>()
+		____.push<int>()
+		________.max(5)
+		____.pop()
+		.pop();
+	root.reset_lookup_stats();
+
+	const TestStruct instance{};
+	EXPECT_EQ(root.get_member(instance, instance.a).get_max(), 5);
+	/* Resolving through the TestStruct scope must not show up as a get<int> */
+	EXPECT_EQ(root.lookup_stats().total.lookups(), 0u);
+	EXPECT_EQ(root.lookup_stats().total.auto_inserts, 0u);
+}
+
+static std::vector<svh::trace_event> traced;
+
+TEST(Instrument, trace_hook) {
+	svh::scope<type_settings> root;
+	root.push<int>().pop();
+	traced.clear();
+
+	const svh::trace_hook previous = svh::set_trace_hook([](const svh::trace_event& event) { traced.push_back(event); });
+	root.get<int>();
+	root.get<float>();
+	EXPECT_NE(svh::set_trace_hook(previous), nullptr);
+	root.get<int>();
+
+	if (!SVH_INSTRUMENT) {
+		EXPECT_TRUE(traced.empty());
+		return;
+	}
+	ASSERT_EQ(traced.size(), 3u);
+	EXPECT_EQ(traced[0].kind, svh::trace_kind::lookup);
+	EXPECT_EQ(traced[0].type, svh::type_id::of<int>());
+	EXPECT_EQ(traced[0].origin, &root);
+	EXPECT_TRUE(traced[0].found);
+	EXPECT_FALSE(traced[1].found);
+	EXPECT_EQ(traced[2].kind, svh::trace_kind::auto_insert);
+	EXPECT_EQ(traced[2].type, svh::type_id::of<float>());
+}
+
+/* Memory resource tests */
+struct counting_resource : std::pmr::memory_resource {
+	std::pmr::memory_resource* upstream;
+	std::size_t allocations = 0;
+	std::size_t bytes = 0;
+
+	explicit counting_resource(std::pmr::memory_resource* upstream) : upstream(upstream) {}
+
+	void* do_allocate(std::size_t size, std::size_t alignment) override {
+		++allocations;
+		bytes += size;
+		return upstream->allocate(size, alignment);
+	}
+	void do_deallocate(void* p, std::size_t size, std::size_t alignment) override {
+		upstream->deallocate(p, size, alignment);
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+};
+
+TEST(Resource, tree_uses_resource) {
+	std::pmr::monotonic_buffer_resource arena;
+	counting_resource counter(&arena);
+
+	/* Anything allocated from the default resource while building fails */
+	std::pmr::memory_resource* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+	{
+		svh::scope<type_settings> root(&counter);
+		root.push<int>()
+			____.min(-50)
+			____.max(50)
+			.pop()
+			.push<MyStruct, int>()
+			____.max(20)
+			.pop(2)
+			.push<TestStruct>()
+			____.push_member<&TestStruct::a>()
+			________.max(10)
+			____.pop()
+			.pop();
+
+		auto& mystruct_int_settings = root.get<MyStruct, int>();
+		EXPECT_EQ(mystruct_int_settings.get_min(), -50);
+		EXPECT_EQ(mystruct_int_settings.get_max(), 20);
+		EXPECT_EQ(root.get<TestStruct>().get_member<&TestStruct::a>().get_max(), 10);
+	}
+	std::pmr::set_default_resource(previous);
+
+	EXPECT_GT(counter.allocations, 0u);
+}
+
+/* Footprint of leaf scopes, which make up most of a tree */
+TEST(Footprint, leaf_nodes) {
+	struct Wide {
+		int values[256];
+	} wide{};
+
+	counting_resource counter(std::pmr::new_delete_resource());
+	svh::scope<type_settings> root(&counter);
+	auto& wide_settings = root.push<Wide>();
+	const std::size_t before = counter.bytes;
+	for (const int& value : wide.values) {
+		wide_settings.get_member(wide, value);
+	}
+	const std::size_t bytes_per_leaf = (counter.bytes - before) / 256;
+
+	std::cout << "sizeof(scope) = " << sizeof(svh::scope<type_settings>)
+		<< ", sizeof(type_settings<int>) = " << sizeof(type_settings<int>)
+		<< ", bytes per leaf including its parent's tables = " << bytes_per_leaf << "\n";
+
+	/* Child tables and the resolve cache are allocated on first use, a leaf carries a null pointer for each */
+	EXPECT_LE(sizeof(svh::scope<type_settings>), 10 * sizeof(void*));
+	EXPECT_LT(bytes_per_leaf, sizeof(type_settings<int>) + 16 * sizeof(void*));
+}
+
+/* Copy-on-write tests */
+struct Palette {};
+
+template<>
+struct type_settings<Palette> : svh::scope<type_settings> {
+	svh::cow<std::vector<std::string>> _colors;
+
+	type_settings& colors(std::vector<std::string> v) { _colors = std::move(v); return *this; }
+	type_settings& add_color(const std::string& v) { _colors.write().push_back(v); return *this; }
+
+	const std::vector<std::string>& get_colors() const { return _colors; }
+	bool is_shared() const { return _colors.shared(); }
+};
+
+TEST(Cow, shared_until_write) {
+	svh::scope<type_settings> root;
+	root.push<Palette>()
+		____.colors({ "red", "green" })
+		.pop()
+		.push<MyStruct>()
+		____.push<Palette>()
+		____.pop()
+		.pop();
+
+	auto& palette = root.get<Palette>();
+	auto& nested_palette = root.get<MyStruct, Palette>();
+	EXPECT_EQ(&palette.get_colors(), &nested_palette.get_colors());
+	EXPECT_TRUE(nested_palette.is_shared());
+
+	nested_palette.add_color("blue");
+	EXPECT_FALSE(nested_palette.is_shared());
+	EXPECT_EQ(palette.get_colors().size(), 2u);
+	EXPECT_EQ(nested_palette.get_colors().size(), 3u);
+	EXPECT_EQ(nested_palette.get_colors()[2], "blue");
+}
+
+TEST(Cow, default_value) {
+	svh::scope<type_settings> root;
+	auto& palette = root.push<Palette>();
+	EXPECT_TRUE(palette.get_colors().empty());
+	EXPECT_FALSE(palette.is_shared());
+
+	palette.add_color("red");
+	EXPECT_EQ(palette.get_colors().size(), 1u);
+}
+
+/* Sparse field tests */
+struct Range {};
+
+template<>
+struct type_settings<Range> : svh::scope<type_settings>, svh::sparse_fields<int, int, std::string> {
+	enum { min_field, max_field, label_field };
+
+	type_settings() : sparse_fields(0, 100, "range") {}
+
+	type_settings& min(int v) { set_field<min_field>(v); return *this; }
+	type_settings& max(int v) { set_field<max_field>(v); return *this; }
+	type_settings& label(const std::string& v) { set_field<label_field>(v); return *this; }
+
+	int get_min() const { return field<min_field>(); }
+	int get_max() const { return field<max_field>(); }
+	const std::string& get_label() const { return field<label_field>(); }
+};
+
+TEST(Sparse, stores_only_overrides) {
+	svh::scope<type_settings> root;
+	root.push<Range>()
+		____.min(-10)
+		.pop()
+		.push<MyStruct>()
+		____.push<Range>()
+		________.max(10)
+		____.pop()
+		.pop();
+
+	auto& range = root.get<Range>();
+	auto& nested_range = root.get<MyStruct, Range>();
+	EXPECT_EQ(range.get_min(), -10);
+	EXPECT_EQ(range.get_max(), 100);
+	EXPECT_EQ(nested_range.get_min(), -10);
+	EXPECT_EQ(nested_range.get_max(), 10);
+	EXPECT_EQ(&nested_range.get_label(), &range.get_label());
+
+	EXPECT_FALSE(nested_range.overrides<type_settings<Range>::min_field>());
+	EXPECT_TRUE(nested_range.overrides<type_settings<Range>::max_field>());
+	EXPECT_LT(nested_range.stored_bytes(), range.stored_bytes());
+
+	/* Not overridden, so later changes to the parent show through */
+	range.label("updated");
+	EXPECT_EQ(nested_range.get_label(), "updated");
+}
+
+TEST(Sparse, reset_keeps_defaults) {
+	svh::scope<type_settings> root;
+	root.push<Range>().min(5).label("custom");
+	EXPECT_EQ(root.get<Range>().get_min(), 5);
+
+	auto& range = root.push_default<Range>();
+	EXPECT_EQ(range.get_min(), 0);
+	EXPECT_EQ(range.get_max(), 100);
+	EXPECT_EQ(range.get_label(), "range");
+}
+
+TEST(Sparse, copies_outside_push_store_values) {
+	std::vector<type_settings<Range>> ranges;
+	ranges.reserve(2);
+	ranges.push_back(type_settings<Range>{}.max(7));
+	{
+		type_settings<Range> source;
+		source.label("copied");
+		ranges.push_back(source);
+	}
+	EXPECT_EQ(ranges[0].get_max(), 7);
+	EXPECT_EQ(ranges[0].get_label(), "range");
+	EXPECT_EQ(ranges[1].get_label(), "copied");
+	EXPECT_EQ(ranges[1].get_max(), 100);
+}
+
+struct RangeHolder {
+	Range range;
+};
+
+TEST(Sparse, copies_outlive_freed_source) {
+	svh::scope<type_settings> root;
+	root.push<RangeHolder>()
+		____.push_member<&RangeHolder::range>()
+		________.max(7)
+		________.label("member")
+		____.pop()
+		.pop();
+
+	/* Copied from the member settings inside the RangeHolder subtree */
+	auto& copy = root.push<MyStruct>().push_member<&RangeHolder::range>();
+	EXPECT_FALSE(copy.overrides<type_settings<Range>::max_field>());
+	EXPECT_EQ(copy.get_max(), 7);
+
+	root.push_default<RangeHolder>(); /* Frees the member settings the copy reads from */
+	EXPECT_EQ(copy.get_max(), 7);
+	EXPECT_EQ(copy.get_label(), "member");
+	EXPECT_EQ(copy.get_min(), 0);
+}
+
+/* Concurrency tests */
+template<int N>
+struct Slot {};
+
+TEST(Concurrency, frozen_readers) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.max(50)
+		.pop()
+		.push<MyStruct>()
+		____.push<int>()
+		________.max(20)
+		____.pop()
+		.pop();
+
+	const auto frozen = root.freeze();
+	std::vector<std::thread> threads;
+	std::atomic<int> mismatches{ 0 };
+	for (int t = 0; t < 8; ++t) {
+		threads.emplace_back([&] {
+			for (int i = 0; i < 10000; ++i) {
+				if (frozen.get<int>().get_max() != 50 || frozen.get<MyStruct, int>().get_max() != 20) {
+					++mismatches;
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	EXPECT_EQ(mismatches.load(), 0);
+}
+
+TEST(Concurrency, const_readers) {
+	if (SVH_RESOLVE_CACHE && !SVH_THREAD_SAFE) {
+		return; /* Const lookups fill the resolve cache */
+	}
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.max(50)
+		.pop()
+		.push_member<&TestStruct::b>()
+		____.max(5)
+		.pop()
+		.push<MyStruct>()
+		____.push<float>()
+		____.pop()
+		.pop();
+
+	const svh::scope<type_settings>& tree = root;
+	const svh::scope<type_settings> fresh; /* Its state is created by whichever reader comes first */
+	const TestStruct instance{};
+	std::vector<std::thread> threads;
+	std::atomic<int> mismatches{ 0 };
+	for (int t = 0; t < 8; ++t) {
+		threads.emplace_back([&] {
+			for (int i = 0; i < 10000; ++i) {
+				const auto& nested = tree.get<MyStruct, float>();
+				if (nested.get<int>().get_max() != 50 || tree.get_member(instance, instance.b).get_max() != 5 || tree.find<bool>() || fresh.find<int>()) {
+					++mismatches;
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	EXPECT_EQ(mismatches.load(), 0);
+}
+
+template<int... N>
+static void insert_slots(svh::scope<type_settings>& root, std::vector<const void*>& seen, std::integer_sequence<int, N...>) {
+	((seen[N] = &root.get<MyStruct>().get<Slot<N>>()), ...);
+}
+
+TEST(Concurrency, auto_insert) {
+	if (!SVH_THREAD_SAFE) {
+		return; /* Concurrent gets are only synchronized with SVH_THREAD_SAFE */
+	}
+
+	svh::scope<type_settings> root;
+	root.push<int>().max(50).pop();
+	const auto& const_root = root;
+
+	constexpr int thread_count = 16;
+	using slots = std::make_integer_sequence<int, 8>;
+	std::vector<std::vector<const void*>> seen(thread_count, std::vector<const void*>(slots::size()));
+	std::vector<std::thread> threads;
+	std::atomic<int> mismatches{ 0 };
+	for (int t = 0; t < thread_count; ++t) {
+		threads.emplace_back([&, t] {
+			for (int i = 0; i < 1000; ++i) {
+				insert_slots(root, seen[t], slots{});
+				if (const_root.get<int>().get_max() != 50 || root.get_member<&TestStruct::a>().get_max() != 50) {
+					++mismatches;
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	EXPECT_EQ(mismatches.load(), 0);
+	for (int t = 1; t < thread_count; ++t) {
+		EXPECT_EQ(seen[t], seen[0]); /* Every thread resolved to the one inserted scope */
+	}
+}
+
+/* Children map tests */
+template<int... N>
+static void push_slots(svh::scope<type_settings>& root, std::integer_sequence<int, N...>) {
+	((root.push<Slot<N>>().template push<int>().max(N)), ...);
+}
+
+template<int... N>
+static bool check_slots(svh::scope<type_settings>& root, std::integer_sequence<int, N...>) {
+	return ((root.template get<Slot<N>, int>().get_max() == N) && ...);
+}
+
+TEST(Children, many_children) {
+	/* Past a few children the scope maps switch from a linear scan to hashing */
+	svh::scope<type_settings> root;
+	using slots = std::make_integer_sequence<int, 40>;
+	push_slots(root, slots{});
+	EXPECT_TRUE(check_slots(root, slots{}));
+
+	struct Wide {
+		int values[40];
+	} wide{};
+	auto& wide_settings = root.push<Wide>();
+	for (int i = 0; i < 40; ++i) {
+		wide_settings.get_member(wide, wide.values[i]).max(i);
+	}
+	for (int i = 0; i < 40; ++i) {
+		EXPECT_EQ(wide_settings.get_member(wide, wide.values[i]).get_max(), i);
+	}
+}
+
+/* Versioned tree tests */
+TEST(Versioned, publish) {
+	svh::versioned_scope<type_settings> settings;
+	settings.update([](svh::scope<type_settings>& root) {
+		root.push<int>()
+			____.min(-50)
+			____.max(50)
+			.pop()
+			.push<Range>()
+			____.max(10)
+			.pop();
+	});
+
+	auto before = settings.read();
+	EXPECT_EQ(before.number(), 2u);
+	EXPECT_EQ(before->get<int>().get_max(), 50);
+
+	settings.update([](svh::scope<type_settings>& root) {
+		root.get<int>().max(20);
+		root.push<MyStruct>()
+			____.push<int>()
+			________.min(0)
+			____.pop()
+			.pop();
+	});
+
+	/* The held version is unchanged */
+	EXPECT_EQ(before->get<int>().get_max(), 50);
+	EXPECT_EQ(before->get<Range>().get_max(), 10);
+	EXPECT_EQ(settings.retired_count(), 1u);
+
+	auto after = settings.read();
+	EXPECT_EQ(after.number(), 3u);
+	EXPECT_EQ(after->get<int>().get_max(), 20);
+	auto& mystruct_int_settings = after->get<MyStruct, int>();
+	EXPECT_EQ(mystruct_int_settings.get_min(), 0);
+	EXPECT_EQ(after->get<Range>().get_max(), 10);
+	EXPECT_NE(&after->get<Range>(), &before->get<Range>());
+
+	/* Released versions are reclaimed */
+	before = settings.read();
+	settings.reclaim();
+	EXPECT_EQ(settings.retired_count(), 0u);
+}
+
+TEST(Versioned, member_settings_carried_over) {
+	svh::versioned_scope<type_settings> settings;
+	settings.update([](svh::scope<type_settings>& root) {
+		root.push<TestStruct>()
+			____.push_member<&TestStruct::b>()
+			________.max(10)
+			____.pop()
+			.pop();
+	});
+	settings.update([](svh::scope<type_settings>& root) { root.push<int>().max(50).pop(); });
+
+	/* Runtime lookups in the copied tree must still see the member pushed in an older version */
+	const TestStruct instance{ 1, 2 };
+	auto snapshot = settings.read();
+	const auto& struct_settings = snapshot->get<TestStruct>();
+	EXPECT_EQ(struct_settings.find_member_runtime(instance, instance.b)->get_max(), 10);
+	EXPECT_EQ(struct_settings.find_member_runtime(instance, instance.a)->get_max(), 50);
+}
+
+TEST(Versioned, concurrent_readers) {
+	svh::versioned_scope<type_settings> settings;
+	settings.update([](svh::scope<type_settings>& root) { root.push<int>().min(0).max(0).pop(); });
+
+	std::atomic<bool> done{ false };
+	std::atomic<int> torn{ 0 };
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 8; ++t) {
+		readers.emplace_back([&] {
+			while (!done.load()) {
+				auto snapshot = settings.read();
+				const auto& int_settings = snapshot->get<int>();
+				if (int_settings.get_min() != -int_settings.get_max()) {
+					++torn;
+				}
+			}
+		});
+	}
+
+	for (int i = 1; i <= 200; ++i) {
+		settings.update([i](svh::scope<type_settings>& root) { root.get<int>().min(-i).max(i); });
+	}
+	done = true;
+	for (auto& reader : readers) {
+		reader.join();
+	}
+
+	EXPECT_EQ(torn.load(), 0);
+	EXPECT_EQ(settings.read()->get<int>().get_max(), 200);
+	settings.reclaim();
+	EXPECT_EQ(settings.retired_count(), 0u);
+}
+
+/* Member hash tests */
+TEST(Hash, member_keys_distinct) {
+	/* Swapped types and offsets overlapping the type bits used to cancel out */
+	std::unordered_set<std::size_t> hashes;
+	std::size_t keys = 0;
+	for (std::uint32_t struct_type = 0; struct_type < 16; ++struct_type) {
+		for (std::uint32_t member_type = 0; member_type < 16; ++member_type) {
+			for (std::size_t offset = 0; offset < 1024; offset += 4) {
+				hashes.insert(svh::member_hash{}(svh::type_id{ struct_type }, svh::type_id{ member_type }, offset));
+				++keys;
+			}
+		}
+	}
+	EXPECT_EQ(hashes.size(), keys);
+}
+
+/* Frozen snapshot tests */
+TEST(Frozen, get) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.min(-50)
+		____.max(50)
+		.pop()
+		.push<MyStruct>()
+		____.push<int>()
+		________.max(20)
+		____.pop()
+		.pop();
+
+	const auto frozen = root.freeze();
+	auto& int_settings = frozen.get<int>();
+	EXPECT_EQ(int_settings.get_min(), -50);
+	EXPECT_EQ(int_settings.get_max(), 50);
+
+	auto& mystruct_int_settings = frozen.get<MyStruct, int>();
+	EXPECT_EQ(&mystruct_int_settings, &root.get<MyStruct>().get<int>());
+	EXPECT_EQ(mystruct_int_settings.get_min(), -50);
+	EXPECT_EQ(mystruct_int_settings.get_max(), 20);
+
+	EXPECT_EQ(frozen.find<float>(), nullptr);
+	EXPECT_SCOPE_ERROR(frozen.get<float>());
+}
+
+TEST(Frozen, fallback) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.min(0)
+		____.max(50)
+		.pop()
+		.push<MyStruct>()
+		____.push<bool>()
+		____.pop()
+		.pop();
+
+	const auto frozen = root.freeze();
+	auto bool_node = frozen.at<MyStruct, bool>();
+	auto& int_settings = bool_node.get<int>();
+	EXPECT_EQ(&int_settings, &root.get<int>());
+	EXPECT_EQ(&bool_node.source(), &root.get<MyStruct>().get<bool>());
+}
+
+TEST(Frozen, subtree) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.min(-50)
+		____.max(50)
+		.pop()
+		.push<MyStruct>()
+		.pop();
+
+	const auto frozen = root.get<MyStruct>().freeze();
+	auto& int_settings = frozen.get<int>();
+	EXPECT_EQ(int_settings.get_min(), -50);
+	EXPECT_EQ(int_settings.get_max(), 50);
+}
+
+TEST(Frozen, member_variable) {
+	svh::scope<type_settings> root;
+	root.push<TestStruct>()
+		____.push<int>()
+		________.min(0)
+		________.max(5)
+		____.pop()
+		____.push_member<&TestStruct::b>()
+		________.max(10)
+		____.pop()
+		.pop();
+
+	const auto frozen = root.freeze();
+	auto& a_settings = frozen.at<TestStruct>().get_member<&TestStruct::a>();
+	EXPECT_EQ(&a_settings, root.get<TestStruct>().find_member<&TestStruct::a>());
+	EXPECT_EQ(a_settings.get_max(), 5);
+
+	auto& b_settings = frozen.at<TestStruct>().get_member<&TestStruct::b>();
+	EXPECT_EQ(b_settings.get_min(), 0);
+	EXPECT_EQ(b_settings.get_max(), 10);
+}
+
+struct Wrapper {
+	int value;
+	float scale;
+};
+
+TEST(Frozen, member_not_stored) {
+	svh::scope<type_settings> root;
+	root.push<float>()
+		____.max(2.0f)
+		.pop()
+		.push<TestStruct>()
+		____.push<int>()
+		________.max(5)
+		____.pop()
+		.pop()
+		.push_member<&Wrapper::value>()
+		____.max(7)
+		____.push<int>()
+		________.max(8)
+		____.pop()
+		.pop();
+
+	const auto frozen = root.freeze();
+	EXPECT_EQ(frozen.at<TestStruct>().get_member<&TestStruct::a>().get_max(), 5);
+	EXPECT_SCOPE_ERROR(frozen.get_member<&TestStruct::a>());
+
+	/* Inside a member scope get<float> stops at the member settings, the unstored member continues to the root */
+	auto int_node = frozen.root().at_member<&Wrapper::value>().at<int>();
+	const auto& live_int = root.get_member<&Wrapper::value>().get<int>();
+	EXPECT_SCOPE_ERROR(int_node.get<float>());
+	EXPECT_EQ(&int_node.get_member<&Wrapper::scale>(), live_int.find_member<&Wrapper::scale>());
+	EXPECT_EQ(int_node.get_member<&Wrapper::scale>().get_max(), 2.0f);
+
+	/* Resolved when freezing, members pushed afterwards only show in the live tree */
+	root.push_member<&Wrapper::scale>().max(1.0f);
+	EXPECT_EQ(live_int.find_member<&Wrapper::scale>()->get_max(), 1.0f);
+	EXPECT_EQ(int_node.get_member<&Wrapper::scale>().get_max(), 2.0f);
+}
+
+/* Binary serialization tests */
+namespace {
+	/* Saved bytes in a buffer aligned like a mapped file */
+	std::vector<std::uint64_t> save_to_buffer(const svh::scope<type_settings>& tree, std::size_t& size) {
+		std::ostringstream out;
+		svh::save_binary(tree, out);
+		const std::string bytes = out.str();
+		size = bytes.size();
+		std::vector<std::uint64_t> buffer((bytes.size() + 7) / 8);
+		std::memcpy(buffer.data(), bytes.data(), bytes.size());
+		return buffer;
+	}
+}
+
+TEST(Binary, round_trip) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.min(-50)
+		____.max(50)
+		.pop()
+		.push<MyStruct>()
+		____.push<int>()
+		________.max(20)
+		____.pop()
+		____.push<float>()
+		________.min(-1.0f)
+		________.max(1.0f)
+		____.pop()
+		.pop();
+
+	std::size_t size = 0;
+	const auto buffer = save_to_buffer(root, size);
+	const svh::mapped_tree<type_settings> mapped(buffer.data(), size);
+	EXPECT_EQ(mapped.size(), root.freeze().size());
+
+	auto int_settings = mapped.get<int>();
+	EXPECT_EQ(int_settings.get<&type_settings<int>::_min>(), -50);
+	EXPECT_EQ(int_settings.get<&type_settings<int>::_max>(), 50);
+
+	auto mystruct_int_settings = mapped.get<MyStruct, int>();
+	EXPECT_EQ(mystruct_int_settings.get<&type_settings<int>::_min>(), -50);
+	EXPECT_EQ(mystruct_int_settings.get<&type_settings<int>::_max>(), 20);
+
+	const type_settings<float> loaded = mapped.at<MyStruct>().get<float>().load();
+	EXPECT_EQ(loaded.get_min(), -1.0f);
+	EXPECT_EQ(loaded.get_max(), 1.0f);
+
+	EXPECT_FALSE(mapped.find<float>());
+	EXPECT_SCOPE_ERROR(mapped.get<float>());
+	EXPECT_FALSE(mapped.find<bool>());
+}
+
+TEST(Binary, fallback_and_parents) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.max(50)
+		.pop()
+		.push<MyStruct>()
+		____.push<bool>()
+		____.pop()
+		.pop();
+
+	std::size_t size = 0;
+	const auto buffer = save_to_buffer(root.get<MyStruct>(), size);
+	const svh::mapped_tree<type_settings> mapped(buffer.data(), size);
+
+	/* Lookups start where the tree was saved from and fall back to its parents */
+	auto bool_node = mapped.at<bool>();
+	EXPECT_EQ(bool_node.get<int>().get<&type_settings<int>::_max>(), 50);
+	EXPECT_TRUE(bool_node.has_parent());
+	EXPECT_FALSE(bool_node.parent().parent().has_parent());
+	EXPECT_SCOPE_ERROR(bool_node.parent().parent().parent());
+}
+
+TEST(Binary, member_variable) {
+	svh::scope<type_settings> root;
+	root.push<TestStruct>()
+		____.push<int>()
+		________.min(0)
+		________.max(5)
+		____.pop()
+		____.push_member<&TestStruct::b>()
+		________.max(10)
+		____.pop()
+		.pop();
+
+	std::size_t size = 0;
+	const auto buffer = save_to_buffer(root, size);
+	const svh::mapped_tree<type_settings> mapped(buffer.data(), size);
+
+	auto a_settings = mapped.at<TestStruct>().get_member<&TestStruct::a>();
+	EXPECT_EQ(a_settings.get<&type_settings<int>::_max>(), 5);
+
+	auto b_settings = mapped.at<TestStruct>().get_member<&TestStruct::b>();
+	EXPECT_EQ(b_settings.get<&type_settings<int>::_min>(), 0);
+	EXPECT_EQ(b_settings.get<&type_settings<int>::_max>(), 10);
+}
+
+TEST(Binary, member_not_stored) {
+	svh::scope<type_settings> root;
+	root.push<float>()
+		____.max(2.0f)
+		.pop()
+		.push<TestStruct>()
+		____.push<int>()
+		________.max(5)
+		____.pop()
+		.pop()
+		.push_member<&Wrapper::value>()
+		____.max(7)
+		____.push<int>()
+		________.max(8)
+		____.pop()
+		.pop();
+
+	std::size_t size = 0;
+	const auto buffer = save_to_buffer(root, size);
+	const svh::mapped_tree<type_settings> mapped(buffer.data(), size);
+	const auto& live = root;
+
+	/* Members that were never pushed resolve like in the live tree */
+	EXPECT_EQ(live.find_member<&TestStruct::a>(), nullptr);
+	EXPECT_SCOPE_ERROR(mapped.get_member<&TestStruct::a>());
+	EXPECT_EQ(mapped.at<TestStruct>().get_member<&TestStruct::a>().get<&type_settings<int>::_max>(), live.get<TestStruct>().find_member<&TestStruct::a>()->get_max());
+
+	const auto& live_int = live.get_member<&Wrapper::value>().get<int>();
+	auto mapped_int = mapped.root().at_member<&Wrapper::value>().at<int>();
+	EXPECT_EQ(mapped_int.get_member<&Wrapper::scale>().get<&type_settings<float>::_max>(), live_int.find_member<&Wrapper::scale>()->get_max());
+	EXPECT_EQ(mapped_int.get_member<&Wrapper::scale>().get<&type_settings<float>::_max>(), 2.0f);
+}
+
+TEST(Binary, mapped_file) {
+	svh::scope<type_settings> root;
+	root.push<MyStruct>()
+		____.push<int>()
+		________.min(3)
+		____.pop()
+		.pop();
+
+	const std::string path = (std::filesystem::temp_directory_path() / "svh_binary_test.bin").string();
+	svh::save_binary(root, path);
+	{
+		const svh::mapped_tree<type_settings> mapped(path);
+		auto int_settings = mapped.get<MyStruct, int>();
+		EXPECT_EQ(int_settings.get<&type_settings<int>::_min>(), 3);
+	}
+	std::filesystem::remove(path);
+
+	EXPECT_SCOPE_ERROR(svh::mapped_tree<type_settings>{ path });
+}
+
+TEST(Binary, invalid) {
+	svh::scope<type_settings> root;
+	root.push<int>().pop();
+
+	std::size_t size = 0;
+	auto buffer = save_to_buffer(root, size);
+	const void* data = buffer.data();
+	EXPECT_SCOPE_ERROR(svh::mapped_tree<type_settings>(data, size - 1));
+	EXPECT_SCOPE_ERROR(svh::mapped_tree<type_settings>(data, 16));
+
+	reinterpret_cast<char*>(buffer.data())[0] = 'X';
+	EXPECT_SCOPE_ERROR(svh::mapped_tree<type_settings>(data, size));
+}
+
+/* JSON tests */
+namespace {
+	svh::json_registry<type_settings> json_names() {
+		svh::json_registry<type_settings> registry;
+		registry.add<int>("int").add<float>("float").add<MyStruct>("MyStruct").add<TestStruct>("TestStruct");
+		registry.add_member<&TestStruct::b>("TestStruct.b");
+		return registry;
+	}
+}
+
+TEST(Json, text) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.min(-5)
+		____.max(5)
+		.pop()
+		.push<MyStruct>()
+		____.push<int>()
+		________.max(20)
+		____.pop()
+		.pop();
+
+	std::ostringstream out;
+	svh::save_json(root, json_names(), out);
+	EXPECT_EQ(out.str(),
+		"{\n"
+		"\t\"version\": 1,\n"
+		"\t\"children\": [\n"
+		"\t\t{\n"
+		"\t\t\t\"type\": \"MyStruct\",\n"
+		"\t\t\t\"children\": [\n"
+		"\t\t\t\t{\n"
+		"\t\t\t\t\t\"type\": \"int\",\n"
+		"\t\t\t\t\t\"fields\": { \"min\": -5, \"max\": 20 }\n"
+		"\t\t\t\t}\n"
+		"\t\t\t]\n"
+		"\t\t},\n"
+		"\t\t{\n"
+		"\t\t\t\"type\": \"int\",\n"
+		"\t\t\t\"fields\": { \"min\": -5, \"max\": 5 }\n"
+		"\t\t}\n"
+		"\t]\n"
+		"}\n");
+}
+
+TEST(Json, round_trip) {
+	svh::scope<type_settings> root;
+	root.push<float>()
+		____.min(0.1f)
+		____.max(1e30f)
+		.pop()
+		.push<TestStruct>()
+		____.push<int>()
+		________.max(5)
+		____.pop()
+		____.push_member<&TestStruct::b>()
+		________.max(10)
+		____.pop()
+		.pop();
+
+	std::stringstream text;
+	svh::save_json(root, json_names(), text);
+
+	svh::scope<type_settings> loaded;
+	svh::load_json(loaded, json_names(), text);
+	EXPECT_EQ(loaded.get<float>().get_min(), 0.1f);
+	EXPECT_EQ(loaded.get<float>().get_max(), 1e30f);
+	EXPECT_EQ(loaded.get<TestStruct>().get<int>().get_max(), 5);
+	EXPECT_EQ(loaded.get<TestStruct>().get_member<&TestStruct::b>().get_max(), 10);
+	EXPECT_EQ(loaded.get<TestStruct>().get_member<&TestStruct::a>().get_max(), 5);
+}
+
+TEST(Json, inherits_like_push) {
+	svh::scope<type_settings> root;
+	root.push<int>()
+		____.min(-50)
+		____.max(50)
+		.pop();
+
+	/* Fields that are left out, or null, keep what push copied from the parent */
+	std::istringstream text(R"({
+		"version": 1,
+		"children": [
+			{ "type": "MyStruct", "children": [ { "type": "int", "fields": { "max": 20, "min": null } } ] },
+			{ "type": "float", "comment": { "skipped": [1, 2, "]"] } }
+		]
+	})");
+	svh::load_json(root, json_names(), text);
+	auto& int_settings = root.get<MyStruct>().get<int>();
+	EXPECT_EQ(int_settings.get_min(), -50);
+	EXPECT_EQ(int_settings.get_max(), 20);
+	EXPECT_NE(root.find<float>(), nullptr);
+}
+
+TEST(Json, errors) {
+	const auto load = [](const char* text) {
+		svh::scope<type_settings> root;
+		std::istringstream in(text);
+		svh::load_json(root, json_names(), in);
+	};
+	EXPECT_SCOPE_ERROR(load(R"({ "children": [ { "type": "double" } ] })"));
+	EXPECT_SCOPE_ERROR(load(R"({ "children": [ { "type": "int", "fields": { "step": 1 } } ] })"));
+	EXPECT_SCOPE_ERROR(load(R"({ "children": [ { "type": "int", "fields": { "min": "low" } } ] })"));
+	EXPECT_SCOPE_ERROR(load(R"({ "children": [ { "fields": { "min": 1 }, "type": "int" } ] })"));
+	EXPECT_SCOPE_ERROR(load(R"({ "version": 2 })"));
+	EXPECT_SCOPE_ERROR(load(R"({ "children": [ { "type": "int" } )"));
+
+	svh::scope<type_settings> root;
+	root.push<bool>().pop();
+	std::ostringstream out;
+	EXPECT_SCOPE_ERROR(svh::save_json(root, json_names(), out));
+}
+
+TEST(Json, numbers_ignore_locale) {
+	/* Any installed locale with a decimal comma, snprintf and strtod would write and expect "1,5" */
+	const std::string previous = std::setlocale(LC_NUMERIC, nullptr);
+	for (const char* name : { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "German_Germany" }) {
+		if (std::setlocale(LC_NUMERIC, name)) {
+			break;
+		}
+	}
+
+	svh::scope<type_settings> root;
+	root.push<float>()
+		____.min(1.5f)
+		____.max(0.1f)
+		.pop();
+	std::ostringstream out;
+	svh::save_json(root, json_names(), out);
+
+	svh::scope<type_settings> loaded;
+	std::istringstream in(out.str());
+	svh::load_json(loaded, json_names(), in);
+	std::setlocale(LC_NUMERIC, previous.c_str());
+
+	EXPECT_NE(out.str().find(R"("fields": { "min": 1.5, "max": 0.1 })"), std::string::npos);
+	EXPECT_EQ(loaded.get<float>().get_min(), 1.5f);
+	EXPECT_EQ(loaded.get<float>().get_max(), 0.1f);
+}
+
+TEST(Json, save_while_pushing) {
+	if (!SVH_THREAD_SAFE) {
+		return; /* Concurrent pushes are only synchronized with SVH_THREAD_SAFE */
+	}
+	svh::scope<type_settings> root;
+	const auto names = json_names();
+	std::atomic<bool> done{ false };
+	std::thread writer([&] {
+		for (int i = 0; i < 2000; ++i) {
+			root.push<MyStruct>().push<int>();
+			root.push_default<MyStruct>();
+		}
+		done = true;
+	});
+	int saved = 0;
+	while (!done || saved == 0) {
+		std::ostringstream out;
+		svh::save_json(root, names, out);
+		svh::scope<type_settings> copy;
+		std::istringstream in(out.str());
+		svh::load_json(copy, names, in);
+		++saved;
+	}
+	writer.join();
+	EXPECT_GT(saved, 0);
+}
+
+TEST(Json, depth_limit) {
+	const auto nested = [](std::size_t depth) {
+		std::string text = R"({ "children": [)";
+		for (std::size_t i = 1; i < depth; ++i) {
+			text += R"({ "type": "int", "children": [)";
+		}
+		text += R"({ "type": "int" })";
+		for (std::size_t i = 1; i < depth; ++i) {
+			text += "] }";
+		}
+		return text + "] }";
+	};
+	const auto load = [](const std::string& text) {
+		svh::scope<type_settings> root;
+		std::istringstream in(text);
+		svh::load_json(root, json_names(), in);
+	};
+
+	load(nested(svh::detail::json::max_depth));
+	EXPECT_SCOPE_ERROR(load(nested(svh::detail::json::max_depth + 1)));
+	EXPECT_SCOPE_ERROR(load(nested(100000))); /* Would overflow the stack if it recursed that far */
+}
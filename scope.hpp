@@ -6,12 +6,76 @@
 #include <stdexcept>
 #include <memory>
 #include <type_traits>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <limits>
+#include <cstdint>
+#include <memory_resource>
+#include <tuple>
+#include <utility>
+#include <new>
+#include <optional>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
 
 /* Whether to insert a default object when calling get at root level if not found in any scope*/
 #ifndef SVH_AUTO_INSERT
 #define SVH_AUTO_INSERT true
 #endif
 
+/* Whether to downcast children by comparing a type tag recorded at creation instead of using dynamic_cast */
+#ifndef SVH_TYPE_TAGS
+#define SVH_TYPE_TAGS false
+#endif
+
+/* Whether scopes memoize the scope each type resolves to, invalidated whenever the tree changes. Ignored with SVH_THREAD_SAFE.
+Const lookups fill the cache too, so a tree must not be read from several threads at once */
+#ifndef SVH_RESOLVE_CACHE
+#define SVH_RESOLVE_CACHE false
+#endif
+
+/* Whether trees can be read and auto-inserted into from several threads, see ``detail::tree_mutex`` */
+#ifndef SVH_THREAD_SAFE
+#define SVH_THREAD_SAFE false
+#endif
+
+/* Hasher of member keys, called as ``SVH_MEMBER_HASH{}(struct_type, member_type, offset)``. Must be declared before including this header */
+#ifndef SVH_MEMBER_HASH
+#define SVH_MEMBER_HASH svh::member_hash
+#endif
+
+/* Whether tagged downcasts are still verified with dynamic_cast, enabled by default in debug builds */
+#ifndef SVH_CHECKED_CAST
+#ifdef NDEBUG
+#define SVH_CHECKED_CAST false
+#else
+#define SVH_CHECKED_CAST true
+#endif
+#endif
+
+/* Whether failures throw, follows the compiler's setting. Without exceptions they print the message and abort, use the try_ functions to handle them */
+#ifndef SVH_EXCEPTIONS
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+#define SVH_EXCEPTIONS true
+#else
+#define SVH_EXCEPTIONS false
+#endif
+#endif
+
+/* Whether trees count lookups, auto-inserts and push copies per type and scope and call the trace hook, see ``scope::lookup_stats`` */
+#ifndef SVH_INSTRUMENT
+#define SVH_INSTRUMENT false
+#endif
+
 namespace svh {
 
 	/*
@@ -63,568 +127,3252 @@ namespace svh {
 	struct member_pointer_traits<M T::*> {
 		using member_type = simplify_t<M>;
 		using class_type = simplify_t<T>;
+		using declaring_type = T; /* Before simplification, the type the pointer applies to */
 	};
 
+	namespace detail {
+		/* Storage shaped like C, shared by the members of C to measure their offsets. Costs sizeof(C) static bytes per probed class */
+		template<class C>
+		struct offset_probe {
+			alignas(C) static inline unsigned char bytes[sizeof(C)];
+		};
+	}
+
+	/*
+	Offset of a member in its class, measured on static storage for the class rather than through a null pointer.
+	offsetof needs the member's name, so there is no defined way to get the offset from a member pointer: applying
+	the pointer to bytes that never held a C is undefined behavior, like the null pointer trick. It relies on GCC,
+	Clang and MSVC computing the address without reading the storage, which also works for abstract classes
+	and keeps sanitizers quiet. Compilers fold the difference to a constant.
+	*/
 	template<auto member>
 	std::size_t get_member_offset() {
-		using traits = member_pointer_traits<decltype(member)>;
-		using C = typename traits::class_type;
-		return reinterpret_cast<std::size_t>(&(reinterpret_cast<C const volatile*>(0)->*member));
+		using C = typename member_pointer_traits<decltype(member)>::declaring_type;
+		const unsigned char* bytes = detail::offset_probe<C>::bytes;
+		const C& object = *reinterpret_cast<const C*>(bytes);
+		return static_cast<std::size_t>(reinterpret_cast<const unsigned char*>(&(object.*member)) - bytes);
 	}
-}
 
-namespace svh {
+	/* Why a try_ lookup did not return a scope */
+	enum class scope_error : std::uint8_t {
+		none,
+		not_found,      /* No scope holds the type or member */
+		type_mismatch,  /* The scope found holds a different type than requested */
+		out_of_bounds,  /* The member is not inside the instance it was given with */
+	};
 
-	template<template<class> class BaseTemplate>
-	struct scope {
-	private:
-		struct member_id; // Forward declare
-	public:
+	inline const char* to_string(scope_error error) {
+		switch (error) {
+		case scope_error::none: return "No error";
+		case scope_error::not_found: return "Not found";
+		case scope_error::type_mismatch: return "Existing scope has unexpected type";
+		case scope_error::out_of_bounds: return "Member is not within instance bounds";
+		}
+		return "Unknown error";
+	}
 
-		virtual ~scope() = default; // Needed for dynamic_cast
-		scope() = default;
+	namespace detail {
+		/* Throw Exception with message, or print it and abort when built without exceptions */
+		template<class Exception = std::runtime_error>
+		[[noreturn]] inline void raise(const char* message) {
+#if SVH_EXCEPTIONS
+			throw Exception(message);
+#else
+			std::fprintf(stderr, "svh: %s\n", message);
+			std::abort();
+#endif
+		}
 
-		/// <summary>
-		/// Push a new scope for type T. If one already exists, it is returned.
-		/// Else if a parent has one, it is copied.
-		/// Else, a new one is created.
-		/// </summary>
-		/// <typeparam name="T">The type of the scope to push</typeparam>
-		/// <returns>Reference to the pushed scope</returns>
-		/// <exception cref="std::runtime_error">If an existing child has an unexpected type</exception>
-		template<class T>
-		BaseTemplate<simplify_t<T>>& push() {
-			return _push<simplify_t<T>>();
+		template<class Exception = std::runtime_error>
+		[[noreturn]] inline void raise(const std::string& message) {
+			raise<Exception>(message.c_str());
 		}
+	}
 
-		template<template<class...> class T>
-		BaseTemplate<simplify_template_t<T>>& push() {
-			return _push<simplify_template_t<T>>();
+	/// <summary>
+	/// Outcome of a non-throwing lookup: the scope found, or why there is none.
+	/// </summary>
+	/// <typeparam name="T">The settings type looked up</typeparam>
+	template<class T>
+	class result {
+	public:
+		static result success(T* found) { return result(found, scope_error::none); }
+		static result failure(scope_error error) { return result(nullptr, error); }
+
+		bool has_value() const { return found != nullptr; }
+		explicit operator bool() const { return has_value(); }
+		scope_error error() const { return reason; }
+
+		/* nullptr on failure */
+		T* get() const { return found; }
+		T& operator*() const { return *found; }
+		T* operator->() const { return found; }
+
+		/* The scope, raising the error when there is none */
+		T& value() const {
+			if (!found) {
+				detail::raise(to_string(reason));
+			}
+			return *found;
 		}
+	private:
+		result(T* found, scope_error reason) : found(found), reason(reason) {}
 
-		/// <summary>
-		/// Push multiple scopes in order.
-		/// </summary>
-		/// <typeparam name="T">First types</typeparam>
-		/// <typeparam name="U">Second type</typeparam>
-		/// <typeparam name="...Rest">Chain other Types</typeparam>
-		/// <returns>Reference to the last pushed scope</returns>
-		template<class T, class U, class... Rest>
-		auto& push() {
-			auto& next = _push<simplify_t<T>>();
-			/* If rest is something, we recurse */
-			/* If rest is nothing, we fall back to single T push */
-			return next.template push<simplify_t<U>, Rest...>();
+		T* found;
+		scope_error reason;
+	};
+
+	namespace detail {
+		/* Marker for an empty slot in flattened tables */
+		constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+		/* FNV-1a, 64 bit */
+		constexpr std::uint64_t fnv1a(std::string_view text, std::uint64_t hash = 0xcbf29ce484222325ULL) {
+			for (const char c : text) {
+				hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+			}
+			return hash;
 		}
 
-		/// <summary>
-		/// Push a new scope for type T with default values.
-		/// </summary>
-		/// <typeparam name="T">The type of the scope to push</typeparam>
-		/// <returns>Reference to the pushed scope</returns>
-		/// <exception cref="std::runtime_error">If an existing child has an unexpected type</exception>
-		template<class T>
-		BaseTemplate<simplify_t<T>>& push_default() {
-			const std::type_index key = get_type_key<simplify_t<T>>();
+		constexpr std::uint64_t fnv1a(std::uint64_t value, std::uint64_t hash) {
+			for (int byte = 0; byte < 8; ++byte) {
+				hash = (hash ^ ((value >> (byte * 8)) & 0xff)) * 0x100000001b3ULL;
+			}
+			return hash;
+		}
 
-			/* reset if present */
-			auto it = children.find(key);
-			if (it != children.end()) {
-				auto* found = dynamic_cast<BaseTemplate<simplify_t<T>>*>(it->second.get());
-				if (!found) {
-					throw std::runtime_error("Existing child has unexpected type");
+		/* T as spelled in the signature of this function by the compiler */
+		template<class T>
+		constexpr std::string_view pretty_name() {
+#if defined(_MSC_VER) && !defined(__clang__)
+			constexpr std::string_view signature = __FUNCSIG__; /* ... pretty_name<T>(void) */
+			constexpr std::size_t start = signature.find("pretty_name<") + 12;
+			constexpr std::size_t end = signature.rfind(">(void)");
+			std::string_view name = signature.substr(start, end - start);
+			/* MSVC spells out the kind of class types */
+			for (std::string_view kind : { "struct ", "class ", "enum ", "union " }) {
+				if (name.substr(0, kind.size()) == kind) {
+					name.remove_prefix(kind.size());
 				}
-				*found = BaseTemplate<simplify_t<T>>{}; // Reset to default
-				return *found;
 			}
-
-			/* Else create new */
-			return emplace_new<simplify_t<T>>();
+			return name;
+#else
+			constexpr std::string_view signature = __PRETTY_FUNCTION__; /* ... pretty_name() [with T = T; ...] or [T = T] */
+			constexpr std::size_t start = signature.find("T = ") + 4;
+			constexpr std::size_t semicolon = signature.find(';', start);
+			constexpr std::size_t end = semicolon != std::string_view::npos ? semicolon : signature.rfind(']');
+			return signature.substr(start, end - start);
+#endif
 		}
+	}
 
-		/// <summary>
-		/// Push member settings. Creates new or returns existing.
-		/// </summary>
-		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
-		/// <returns>Reference to member settings</returns>
-		template<auto member>
-		auto& push_member() {
-			using traits = member_pointer_traits<decltype(member)>;
-			using MemberType = typename traits::member_type;
-			using ClassType = typename traits::class_type;
+	/*
+	Name of T in logs and saved trees, derived from the compiler's spelling of the type at compile time.
+	Names agree across builds with the same compiler family. Specialize it to give a type the same name everywhere:
+	template<> struct svh::type_name<MyStruct> { static constexpr std::string_view value = "MyStruct"; };
+	*/
+	template<class T>
+	struct type_name {
+		static constexpr std::string_view value = detail::pretty_name<T>();
+	};
 
-			const std::type_index struct_type = get_type_key<ClassType>();
-			const std::type_index member_type = get_type_key<MemberType>();
-			const std::size_t member_offset = get_member_offset<member>();
-			const auto key = member_id{ struct_type, member_type, member_offset };
+	/* FNV-1a hash of type_name, the key of T in saved trees */
+	template<class T>
+	constexpr std::uint64_t type_hash() {
+		return detail::fnv1a(type_name<T>::value);
+	}
 
-			// Check if already exists in current scope
-			auto it = member_children.find(key);
-			if (it != member_children.end()) {
-				auto* found = dynamic_cast<BaseTemplate<MemberType>*>(it->second.get());
-				if (!found) {
-					throw std::runtime_error("Existing member child has unexpected type");
-				}
-				return *found;
+	namespace detail {
+		/* Process-wide registry handing out dense ids for types */
+		struct type_registry {
+			struct entry {
+				std::type_index type;
+				std::string_view name; /* static storage, from type_name */
+				std::uint64_t hash;
+			};
+
+			std::mutex mutex;
+			std::unordered_map<std::type_index, std::uint32_t> ids;
+			std::vector<entry> types; /* id -> type */
+
+			static type_registry& instance() {
+				static type_registry registry;
+				return registry;
 			}
 
-			// Look for existing in parent to copy
-			if (has_parent()) {
-				auto* found = find_member<member>();
-				if (found) {
-					auto child = std::make_unique<BaseTemplate<MemberType>>(*found);
-					auto& ref = *child;
-					child->parent = this;
-					child->children.clear(); // Clear inherited children
-					child->member_children.clear(); // Clear inherited member children
-					child->active_member = key;
-					member_children.emplace(key, std::move(child));
-					return ref;
+			/* Names need not be unique in memory, e.g. types in anonymous namespaces of different files. Saving rejects collisions */
+			std::uint32_t intern(const std::type_index& key, std::string_view name, std::uint64_t hash) {
+				std::lock_guard<std::mutex> lock(mutex);
+				auto found = ids.find(key);
+				if (found != ids.end()) {
+					return found->second;
 				}
-			}
-
-			// Create new
-			auto child = std::make_unique<BaseTemplate<MemberType>>();
-			auto& ref = *child;
-			child->parent = this;
-			child->children.clear(); // Clear inherited children
-			child->member_children.clear(); // Clear inherited member children
-			child->active_member = key;
-			member_children.emplace(key, std::move(child));
-			return ref;
-		}
 
-		/// <summary>
-		/// Pop to parent scope. Throws if at root.
-		/// </summary>
-		/// <returns>Reference to the parent scope</returns>
-		/// <exception cref="std::runtime_error">If at root</exception>
-		scope& pop(int count = 1) const {
-			if (!has_parent() && count > 0) {
-				throw std::runtime_error("No parent to pop to");
+				const std::uint32_t id = static_cast<std::uint32_t>(types.size());
+				ids.emplace(key, id);
+				types.push_back(entry{ key, name, hash });
+				return id;
 			}
-			if (count == 1) {
-				return *parent;
+
+			entry at(std::uint32_t id) {
+				std::lock_guard<std::mutex> lock(mutex);
+				return types.at(id);
 			}
+		};
+	}
 
-			return parent->pop(--count);
-		}
+	/*
+	Dense, process-wide id of a type, used as key for the scope maps.
+	Ids are handed out on first use starting at 0, so they hash as a plain integer and can index arrays directly.
+	Interning goes through typeid once per type, so ids also agree across shared library boundaries.
+	Every type also has a stable name and hash, see ``type_name``, which key the type outside of the process.
+	*/
+	struct type_id {
+		std::uint32_t value = detail::npos;
 
-		scope& pop_to_root() {
-			if (is_root()) {
-				return *this;
-			}
-			return parent->pop_to_root();
+		template<class T>
+		static type_id of() {
+			using type = std::decay_t<T>;
+			static const type_id id{ detail::type_registry::instance().intern(typeid(type), type_name<type>::value, type_hash<type>()) };
+			return id;
 		}
 
-		/// <summary>
-		/// Get the scope for type T. If not found, recurse to parent.
-		/// If not found and at root, optionally insert a default one depending on ``SVH_AUTO_INSERT``.
-		/// </summary>
-		/// <typeparam name="T">The type of the scope to get</typeparam>
-		/// <returns>Reference to the found scope</returns>
-		/// <exception cref="std::runtime_error">If not found and at root and ``SVH_AUTO_INSERT`` is false</exception>
-		template <class T>
-		BaseTemplate<simplify_t<T>>& get() {
-			return _get<simplify_t<T>>();
+		bool is_valid() const { return value != detail::npos; }
+
+		/* The std::type_index this id was created from */
+		std::type_index type() const { return detail::type_registry::instance().at(value).type; }
+
+		/* Stable name and its hash, see ``type_name`` */
+		std::string_view name() const { return detail::type_registry::instance().at(value).name; }
+		std::uint64_t hash() const { return detail::type_registry::instance().at(value).hash; }
+
+		bool operator==(const type_id& other) const { return value == other.value; }
+		bool operator!=(const type_id& other) const { return value != other.value; }
+		bool operator<(const type_id& other) const { return value < other.value; }
+	};
+
+	struct type_id_hash {
+		std::size_t operator()(const type_id& id) const {
+			return id.value;
 		}
+	};
 
-		template<template<class...> class T>
-		BaseTemplate<simplify_template_t<T>>& get() {
-			return _get<simplify_template_t<T>>();
+	namespace detail {
+		/* Finalizer of MurmurHash3, every input bit affects every output bit */
+		inline std::uint64_t mix64(std::uint64_t x) {
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdULL;
+			x ^= x >> 33;
+			x *= 0xc4ceb9fe1a85ec53ULL;
+			x ^= x >> 33;
+			return x;
 		}
+	}
 
-		template <class T, class U, class... Rest>
-		auto& get() {
-			auto& next = _get<simplify_t<T>>();
-			/* If rest is something, we recurse */
-			/* If rest is nothing, we fall back to single T get */
-			return next.template get<simplify_t<U>, Rest...>();
+	/*
+	Default hasher of member keys, see ``SVH_MEMBER_HASH``.
+	The two type ids and the offset are mixed in sequence, so swapped types or offsets that differ
+	in the same bits as the member type do not cancel out.
+	*/
+	struct member_hash {
+		std::size_t operator()(type_id struct_type, type_id member_type, std::size_t offset) const {
+			const std::uint64_t types = (static_cast<std::uint64_t>(struct_type.value) << 32) | member_type.value;
+			return static_cast<std::size_t>(detail::mix64(detail::mix64(types) ^ static_cast<std::uint64_t>(offset)));
 		}
+	};
 
-		/// <summary>
-		/// Get the scope for type T. If not found, recurse to parent.
-		/// If not found and at root, throw.
-		/// </summary>
-		/// <typeparam name="T">The type of the scope to get</typeparam>
-		/// <returns>Reference to the found scope</returns>
-		/// <exception cref="std::runtime_error">If not found</exception>
-		template <class T>
-		const BaseTemplate<simplify_t<T>>& get() const {
-			return _get<simplify_t<T>>();
+	/// <summary>
+	/// Layout of the text written by ``scope::dump``.
+	/// </summary>
+	struct dump_options {
+		std::size_t max_depth = std::numeric_limits<std::size_t>::max(); /* Levels below the dumped scope, 1 lists its children only */
+		std::size_t indent = 2; /* Indent characters per level */
+		std::size_t margin = 0; /* Indent characters before every line */
+		char indent_char = '=';
+	};
+
+	/* A scope as seen by the filter of ``scope::dump`` */
+	struct dump_entry {
+		type_id type;         /* Type of the settings */
+		type_id struct_type;  /* Struct of the member for member scopes, invalid otherwise */
+		std::size_t offset;   /* Offset of the member */
+		std::size_t depth;    /* 1 for the children of the dumped scope */
+
+		bool is_member() const { return struct_type.is_valid(); }
+	};
+
+	/* Default filter of ``scope::dump``, keeps every scope */
+	struct dump_all {
+		bool operator()(const dump_entry&) const { return true; }
+	};
+
+	/* Hit and miss counters of the resolution cache */
+	struct resolve_stats {
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+
+		double hit_rate() const {
+			const std::uint64_t total = hits + misses;
+			return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
 		}
+	};
 
-		template <class T, class U, class... Rest>
-		const auto& get() const {
-			auto& next = _get<simplify_t<T>>();
-			/* If rest is something, we recurse */
-			/* If rest is nothing, we fall back to single T get */
-			return next.template get<simplify_t<U>, Rest...>();
+	/* What an instrumented call did, see ``SVH_INSTRUMENT`` */
+	enum class trace_kind {
+		lookup,      /* A type was resolved from a scope, found or not */
+		auto_insert, /* get created missing settings, see ``SVH_AUTO_INSERT`` */
+		push_copy    /* push copied the settings a parent resolved to */
+	};
+
+	struct trace_event {
+		trace_kind kind;
+		type_id type;        /* Type looked up or inserted, the member type for members */
+		const void* origin;  /* Scope the call was made on */
+		std::size_t depth;   /* Parents walked until the type was found, 0 when found in the origin itself */
+		bool found;          /* Whether a lookup resolved */
+	};
+
+	/* Called for every trace_event with ``SVH_INSTRUMENT``, possibly from several threads, see ``set_trace_hook`` */
+	using trace_hook = void (*)(const trace_event& event);
+
+	/* Lookup counters of one type, one scope or the whole tree */
+	struct lookup_counters {
+		static constexpr std::size_t depth_buckets = 8; /* The last bucket also counts deeper fallbacks */
+
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+		std::uint64_t auto_inserts = 0;
+		std::uint64_t push_copies = 0;
+		std::array<std::uint64_t, depth_buckets> fallback_depths{}; /* Hits by parents walked, [0] are the local ones */
+
+		std::uint64_t lookups() const { return hits + misses; }
+		std::uint64_t local() const { return fallback_depths[0]; }
+		std::uint64_t fallbacks() const { return hits - local(); }
+
+		void add(const trace_event& event) {
+			switch (event.kind) {
+			case trace_kind::lookup:
+				if (event.found) {
+					++hits;
+					++fallback_depths[std::min(event.depth, depth_buckets - 1)];
+				} else {
+					++misses;
+				}
+				break;
+			case trace_kind::auto_insert:
+				++auto_inserts;
+				break;
+			case trace_kind::push_copy:
+				++push_copies;
+				break;
+			}
 		}
+	};
 
-		/// Get member settings. Auto-creates if not found at root level.
+	/// <summary>
+	/// Counters of a tree recorded with ``SVH_INSTRUMENT``, see ``scope::lookup_stats``.
+	/// </summary>
+	struct lookup_report {
+		struct scope_counters {
+			const void* origin;   /* Scope the calls were made on */
+			type_id type;         /* Type of its settings, invalid for the root */
+			lookup_counters counters;
+		};
+
+		lookup_counters total;
+		std::vector<std::pair<type_id, lookup_counters>> types; /* Most lookups first */
+		std::vector<scope_counters> scopes; /* Most lookups first */
+
+		/// <summary>
+		/// Write the totals, the fallback depth histogram and one line per type and scope.
 		/// </summary>
-		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
-		/// <returns>Reference to member settings</returns>
-		template<auto member>
-		auto& get_member() {
-			auto* found = find_member<member>();
-			if (found) {
-				return *found;
+		/// <param name="out">Stream to write to</param>
+		/// <param name="limit">Most types and scopes listed</param>
+		void print(std::ostream& out, std::size_t limit = 16) const {
+			out << "lookups " << total.lookups() << ": " << total.local() << " local, " << total.fallbacks() << " fallback, "
+				<< total.misses << " missed, " << total.auto_inserts << " auto-inserted, " << total.push_copies << " push copies\n";
+			out << "fallback depths:";
+			for (std::size_t depth = 0; depth < lookup_counters::depth_buckets; ++depth) {
+				out << ' ' << depth << (depth + 1 == lookup_counters::depth_buckets ? "+=" : "=") << total.fallback_depths[depth];
 			}
-
-			if (SVH_AUTO_INSERT) {
-				return push_member<member>();
+			out << '\n';
+			for (std::size_t i = 0; i < types.size() && i < limit; ++i) {
+				out << "  " << types[i].first.name() << ": ";
+				print_counters(out, types[i].second);
+			}
+			for (std::size_t i = 0; i < scopes.size() && i < limit; ++i) {
+				out << "  scope " << scopes[i].origin << " (" << (scopes[i].type.is_valid() ? scopes[i].type.name() : "root") << "): ";
+				print_counters(out, scopes[i].counters);
 			}
-
-			throw std::runtime_error("Member settings not found");
 		}
 
-		/// Get member settings (const version).
-		/// </summary>
-		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
-		/// <returns>Const reference to member settings</returns>
-		template<auto member>
-		const auto& get_member() const {
-			auto* found = find_member<member>();
-			if (found) {
-				return *found;
+	private:
+		static void print_counters(std::ostream& out, const lookup_counters& counters) {
+			out << counters.local() << " local, " << counters.fallbacks() << " fallback, " << counters.misses << " missed";
+			if (counters.auto_inserts != 0) {
+				out << ", " << counters.auto_inserts << " auto-inserted";
 			}
+			if (counters.push_copies != 0) {
+				out << ", " << counters.push_copies << " push copies";
+			}
+			out << '\n';
+		}
+	};
 
-			throw std::runtime_error("Member settings not found");
+	namespace detail {
+		inline std::atomic<trace_hook>& trace_target() {
+			static std::atomic<trace_hook> hook{ nullptr };
+			return hook;
 		}
 
+		/* Counters of a tree with ``SVH_INSTRUMENT``. Lookups record under a read lock, so this takes its own */
+		struct instrumentation {
+			std::mutex mutex;
+			lookup_counters total;
+			std::vector<lookup_counters> types; /* By type_id */
+			std::unordered_map<const void*, lookup_report::scope_counters> scopes;
+		};
 
-		/// <summary>
-		/// Find the scope for type T. If not found, recurse to parent.
-		/// If not found and at root, return nullptr.
-		/// </summary>
-		/// <typeparam name="T">The type of the scope to find</typeparam>
-		/// <returns>Pointer to the found scope or nullptr if not found</returns>
-		/// <exception cref="std::runtime_error">If an existing child has an unexpected type</exception>
-		template <class T>
-		BaseTemplate<T>* find(const member_id& child_member_id = {}) const {
-			const std::type_index key = get_type_key<T>();
+		/* Stand-in without ``SVH_INSTRUMENT``, so trees do not carry the counters */
+		struct null_instrumentation {};
 
-			/* Check member map */
-			if (child_member_id.is_valid()) {
-				auto mit = member_children.find(child_member_id);
-				if (mit != member_children.end()) {
-					auto* found = dynamic_cast<BaseTemplate<T>*>(mit->second.get());
-					if (!found) {
-						throw std::runtime_error("Existing member child has unexpected type");
-					}
-					return found;
+		inline void record(instrumentation& counters, const trace_event& event, type_id origin_type) {
+			{
+				std::lock_guard<std::mutex> lock(counters.mutex);
+				counters.total.add(event);
+				if (counters.types.size() <= event.type.value) {
+					counters.types.resize(event.type.value + 1);
 				}
-			} else {
-				/* Check current map */
-				auto it = children.find(key);
-				if (it != children.end()) {
-					auto* found = dynamic_cast<BaseTemplate<T>*>(it->second.get());
-					if (!found) {
-						throw std::runtime_error("Existing child has unexpected type");
-					}
-					return found;
+				counters.types[event.type.value].add(event);
+				auto& origin = counters.scopes.try_emplace(event.origin, lookup_report::scope_counters{ event.origin, origin_type, {} }).first->second;
+				origin.counters.add(event);
+			}
+			if (trace_hook hook = trace_target().load(std::memory_order_acquire)) {
+				hook(event);
+			}
+		}
+		inline void record(null_instrumentation&, const trace_event&, type_id) {}
+
+		inline lookup_report report(instrumentation& counters) {
+			lookup_report result;
+			std::lock_guard<std::mutex> lock(counters.mutex);
+			result.total = counters.total;
+			for (std::size_t id = 0; id < counters.types.size(); ++id) {
+				if (counters.types[id].lookups() + counters.types[id].auto_inserts + counters.types[id].push_copies != 0) {
+					result.types.emplace_back(type_id{ static_cast<std::uint32_t>(id) }, counters.types[id]);
 				}
 			}
-
-			/* Recurse to parent */
-			if (has_parent()) {
-				return parent->find<T>(active_member);
+			for (const auto& entry : counters.scopes) {
+				result.scopes.push_back(entry.second);
 			}
-			return nullptr; // Not found
+			std::sort(result.types.begin(), result.types.end(), [](const auto& a, const auto& b) { return a.second.lookups() > b.second.lookups(); });
+			std::sort(result.scopes.begin(), result.scopes.end(), [](const auto& a, const auto& b) { return a.counters.lookups() > b.counters.lookups(); });
+			return result;
 		}
+		inline lookup_report report(null_instrumentation&) { return {}; }
 
-		/// <summary>
-		/// Find member settings. Returns nullptr if not found.
-		/// </summary>
-		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
-		/// <returns>Pointer to member settings or nullptr if not found</returns>
-		template<auto member>
-		auto* find_member() const {
-			using traits = member_pointer_traits<decltype(member)>;
-			using MemberType = typename traits::member_type;
-			using ClassType = typename traits::class_type;
+		inline void reset(instrumentation& counters) {
+			std::lock_guard<std::mutex> lock(counters.mutex);
+			counters.total = {};
+			counters.types.clear();
+			counters.scopes.clear();
+		}
+		inline void reset(null_instrumentation&) {}
+	}
 
-			const std::type_index struct_type = get_type_key<ClassType>();
-			const std::type_index member_type = get_type_key<MemberType>();
-			const std::size_t member_offset = get_member_offset<member>();
-			const auto key = member_id{ struct_type, member_type, member_offset };
+	/// <summary>
+	/// Set the function called for every lookup, auto-insert and push copy with ``SVH_INSTRUMENT``, nullptr to stop tracing.
+	/// Applies to every tree and thread, calls are made after the counters are updated.
+	/// </summary>
+	/// <param name="hook">Function to call, must be thread safe if trees are used from several threads</param>
+	/// <returns>The previous hook</returns>
+	inline trace_hook set_trace_hook(trace_hook hook) {
+		return detail::trace_target().exchange(hook, std::memory_order_acq_rel);
+	}
 
-			/* Check member map */
-			auto it = member_children.find(key);
-			if (it != member_children.end()) {
-				auto* found = dynamic_cast<BaseTemplate<MemberType>*>(it->second.get());
-				if (!found) {
-					throw std::runtime_error("Existing member child has unexpected type");
+	namespace detail {
+		/*
+		Reader/writer lock of a tree with ``SVH_THREAD_SAFE``.
+		Readers lock one shard picked per thread, so readers on different cores do not contend on one cache line.
+		A writer takes one writer mutex, flags the write and then drains the shards one at a time, so it never holds
+		more than two locks. Readers that find the flag set step back and wait on the writer mutex.
+		Writes (pushes, auto-inserts) are expected to be rare next to reads.
+		*/
+		class tree_mutex {
+		public:
+			static constexpr std::size_t shard_count = 64;
+
+			void lock_shared() {
+				std::shared_mutex& own = shards[local_shard()].mutex;
+				for (;;) {
+					own.lock_shared();
+					if (!writing.load(std::memory_order_acquire)) {
+						return;
+					}
+					own.unlock_shared();
+					writer.lock_shared(); /* Wait for the write without holding the shard it is draining */
+					writer.unlock_shared();
 				}
-				return found;
+			}
+			void unlock_shared() { shards[local_shard()].mutex.unlock_shared(); }
+
+			void lock() {
+				writer.lock();
+				writing.store(true, std::memory_order_relaxed);
+				/* Readers that locked a shard before the flag was set are waited for, later ones see the flag */
+				for (auto& shard : shards) {
+					shard.mutex.lock();
+					shard.mutex.unlock();
+				}
+			}
+			void unlock() {
+				writing.store(false, std::memory_order_release);
+				writer.unlock();
+			}
+
+		private:
+			struct alignas(64) shard {
+				std::shared_mutex mutex;
+			};
+			shard shards[shard_count];
+			alignas(64) std::shared_mutex writer;
+			std::atomic<bool> writing{ false };
+
+			static std::size_t local_shard() {
+				static std::atomic<std::size_t> next{ 0 };
+				thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+				return index;
+			}
+		};
+
+		/* Stand-in without ``SVH_THREAD_SAFE``, so trees do not carry the shards */
+		struct null_tree_mutex {
+			void lock_shared() {}
+			void unlock_shared() {}
+			void lock() {}
+			void unlock() {}
+		};
+
+		/* One aligned member offset of a (struct type, member type) pair, see tree_state::member_layouts */
+		struct member_slot {
+			std::size_t hash = 0; /* Hash of the member key, valid when pushed */
+			bool pushed = false; /* Some scope of the tree holds settings for this member */
+		};
+
+		/* State shared by every scope of one tree, owned by the root */
+		struct tree_state {
+			tree_state() = default;
+			explicit tree_state(std::pmr::memory_resource* resource) : resource(resource) {}
+
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource(); /* Backs every node and map of the tree */
+			std::uint64_t generation = 1; /* Bumped whenever scopes are added or reset, 0 marks an empty cache entry */
+			resolve_stats stats;
+			std::conditional_t<SVH_THREAD_SAFE, tree_mutex, null_tree_mutex> mutex;
+			std::conditional_t<SVH_INSTRUMENT, instrumentation, null_instrumentation> instruments;
+			void* root = nullptr; /* The parentless scope that owns this state */
+			/*
+			Member slots by layout id, then by offset / alignof(member type), grown when member settings are pushed.
+			Lets runtime member lookups skip hashing, and skip the member maps entirely for members nobody pushed.
+			*/
+			std::pmr::vector<std::pmr::vector<member_slot>> member_layouts{ resource };
+		};
+
+		struct lock_state {
+			tree_state* tree = nullptr;
+			bool exclusive = false;
+		};
+
+		/* Innermost tree locked by this thread, shared by read and write guards */
+		inline lock_state& held() {
+			thread_local lock_state state;
+			return state;
+		}
+
+		/*
+		Holds the lock of a tree for a public call with ``SVH_THREAD_SAFE``.
+		Calls nested on the same thread and tree, e.g. push_member looking up its parent, reuse the outer lock.
+		*/
+		template<bool Exclusive>
+		class tree_guard {
+		public:
+			explicit tree_guard(tree_state& tree) : previous(held()) {
+				if (!SVH_THREAD_SAFE) {
+					return;
+				}
+				if (previous.tree == &tree) {
+					if (Exclusive && !previous.exclusive) {
+						raise<std::logic_error>("Cannot modify a tree while reading it on the same thread");
+					}
+					return;
+				}
+				if (Exclusive) {
+					tree.mutex.lock();
+				} else {
+					tree.mutex.lock_shared();
+				}
+				locked = &tree;
+				held() = { &tree, Exclusive };
+			}
+
+			~tree_guard() {
+				if (!locked) {
+					return;
+				}
+				held() = previous;
+				if (Exclusive) {
+					locked->mutex.unlock();
+				} else {
+					locked->mutex.unlock_shared();
+				}
+			}
+
+			tree_guard(const tree_guard&) = delete;
+			tree_guard& operator=(const tree_guard&) = delete;
+
+		private:
+			lock_state previous;
+			tree_state* locked = nullptr;
+		};
+
+		using read_guard = tree_guard<false>;
+		using write_guard = tree_guard<true>;
+
+		/* Resource for scopes that are being constructed on this thread, nullptr for the default resource */
+		inline std::pmr::memory_resource*& construction_resource() {
+			thread_local std::pmr::memory_resource* resource = nullptr;
+			return resource;
+		}
+
+		inline std::pmr::memory_resource* current_resource() {
+			std::pmr::memory_resource* resource = construction_resource();
+			return resource ? resource : std::pmr::get_default_resource();
+		}
+
+		/* Route the maps of scopes constructed during its lifetime to a resource */
+		struct construction_scope {
+			std::pmr::memory_resource* previous;
+
+			explicit construction_scope(std::pmr::memory_resource* resource) : previous(construction_resource()) {
+				construction_resource() = resource;
+			}
+			~construction_scope() {
+				construction_resource() = previous;
+			}
+			construction_scope(const construction_scope&) = delete;
+			construction_scope& operator=(const construction_scope&) = delete;
+		};
+
+		/* Bytes of the tree node that push is copying on this thread, the only source sparse_fields copies link to */
+		struct link_source {
+			const char* begin = nullptr;
+			const char* end = nullptr;
+		};
+
+		inline link_source& linked_copy_source() {
+			thread_local link_source source;
+			return source;
+		}
+
+		inline bool links_to(const void* source) {
+			const link_source& node = linked_copy_source();
+			const char* address = static_cast<const char*>(source);
+			return address >= node.begin && address < node.end;
+		}
+
+		/* Let copies made during its lifetime link to node, which detaches them before it is freed */
+		struct linked_copy_scope {
+			link_source previous;
+
+			linked_copy_scope(const void* node, std::size_t size) : previous(linked_copy_source()) {
+				linked_copy_source() = { static_cast<const char*>(node), static_cast<const char*>(node) + size };
+			}
+			~linked_copy_scope() {
+				linked_copy_source() = previous;
+			}
+			linked_copy_scope(const linked_copy_scope&) = delete;
+			linked_copy_scope& operator=(const linked_copy_scope&) = delete;
+		};
+
+		/* Whether a whole tree is being destroyed on this thread, so links between its nodes need not be undone */
+		inline bool& tree_teardown() {
+			thread_local bool teardown = false;
+			return teardown;
+		}
+
+		struct teardown_scope {
+			bool previous;
+
+			explicit teardown_scope(bool whole_tree) : previous(tree_teardown()) {
+				tree_teardown() = previous || whole_tree;
+			}
+			~teardown_scope() {
+				tree_teardown() = previous;
+			}
+			teardown_scope(const teardown_scope&) = delete;
+			teardown_scope& operator=(const teardown_scope&) = delete;
+		};
+
+		/* Gives an allocation back unless released, so a throwing constructor does not leak it. Works without exceptions too */
+		template<class T>
+		struct allocation_guard {
+			std::pmr::polymorphic_allocator<T>& allocator;
+			T* pointer;
+
+			~allocation_guard() {
+				if (pointer) {
+					allocator.deallocate(pointer, 1);
+				}
+			}
+
+			T* release() {
+				T* released = pointer;
+				pointer = nullptr;
+				return released;
+			}
+		};
+
+		/*
+		Map behind the children of a scope. Entries are stored contiguously in insertion order and found with a linear
+		scan while there are few of them, as most scopes hold a handful of children. Past ``linear_limit`` entries an
+		open addressing index (power of two slots, linear probing) of entry positions is kept next to them.
+		Entries are only ever added, or cleared all at once.
+		*/
+		template<class Key, class Value, class Hash>
+		class flat_map {
+		public:
+			using value_type = std::pair<Key, Value>;
+			using iterator = typename std::pmr::vector<value_type>::iterator;
+			using const_iterator = typename std::pmr::vector<value_type>::const_iterator;
+
+			static constexpr std::size_t linear_limit = 8;
+
+			explicit flat_map(std::pmr::memory_resource* resource) : entries(resource), index(resource) {}
+
+			iterator begin() { return entries.begin(); }
+			iterator end() { return entries.end(); }
+			const_iterator begin() const { return entries.begin(); }
+			const_iterator end() const { return entries.end(); }
+
+			std::size_t size() const { return entries.size(); }
+			bool empty() const { return entries.empty(); }
+
+			iterator find(const Key& key) {
+				return entries.begin() + position(key);
+			}
+			const_iterator find(const Key& key) const {
+				return entries.begin() + position(key);
+			}
+
+			/* find with the hash of key computed up front */
+			const_iterator find(const Key& key, std::size_t hash) const {
+				return entries.begin() + position(key, hash);
+			}
+
+			/* Insert a value constructed from args, unless key is present */
+			template<class... Args>
+			std::pair<iterator, bool> emplace(const Key& key, Args&&... args) {
+				const std::size_t found = position(key);
+				if (found != entries.size()) {
+					return { entries.begin() + found, false };
+				}
+
+				entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+				if (index.empty() ? entries.size() > linear_limit : entries.size() * 2 > index.size()) {
+					rebuild();
+				} else if (!index.empty()) {
+					insert_index(entries.size() - 1);
+				}
+				return { entries.end() - 1, true };
+			}
+
+			Value& operator[](const Key& key) {
+				return emplace(key).first->second;
+			}
+
+			void clear() {
+				entries.clear();
+				index.clear();
+			}
+
+		private:
+			/* Position of key in entries, entries.size() if missing */
+			std::size_t position(const Key& key) const {
+				return index.empty() ? scan(key) : probe(key, Hash{}(key));
+			}
+
+			std::size_t position(const Key& key, std::size_t hash) const {
+				return index.empty() ? scan(key) : probe(key, hash);
+			}
+
+			std::size_t scan(const Key& key) const {
+				std::size_t i = 0;
+				while (i < entries.size() && !(entries[i].first == key)) {
+					++i;
+				}
+				return i;
+			}
+
+			std::size_t probe(const Key& key, std::size_t hash) const {
+				const std::size_t mask = index.size() - 1;
+				for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+					const std::uint32_t stored = index[slot];
+					if (stored == 0) {
+						return entries.size();
+					}
+					if (entries[stored - 1].first == key) {
+						return stored - 1;
+					}
+				}
+			}
+
+			void insert_index(std::size_t position) {
+				const std::size_t mask = index.size() - 1;
+				std::size_t slot = Hash{}(entries[position].first) & mask;
+				while (index[slot] != 0) {
+					slot = (slot + 1) & mask;
+				}
+				index[slot] = static_cast<std::uint32_t>(position + 1);
+			}
+
+			/* Index at most half full */
+			void rebuild() {
+				std::size_t slots = 2 * linear_limit;
+				while (slots < entries.size() * 4) {
+					slots <<= 1;
+				}
+				index.assign(slots, 0);
+				for (std::size_t i = 0; i < entries.size(); ++i) {
+					insert_index(i);
+				}
+			}
+
+			std::pmr::vector<value_type> entries;
+			std::pmr::vector<std::uint32_t> index; /* Entry position + 1 per slot, 0 when empty. Empty while scanning linearly */
+		};
+	}
+
+	/*
+	Copy-on-write field for large settings, e.g. strings, vectors or lookup tables.
+	Copies share one value, so a pushed scope refers to its ancestor's value until the first
+	mutating call through ``write()`` or an assignment, which materializes a copy of its own.
+	Values are allocated from the resource of the tree the owning scope was created in.
+	*/
+	template<class T>
+	struct cow {
+		cow() : resource(detail::current_resource()) {}
+		cow(const T& v) : resource(detail::current_resource()) { assign(v); }
+		cow(T&& v) : resource(detail::current_resource()) { assign(std::move(v)); }
+
+		/* Share the value of other, keeping the resource of the scope being constructed */
+		cow(const cow& other) : value(other.value), resource(detail::current_resource()) {}
+		cow& operator=(const cow& other) {
+			value = other.value;
+			return *this;
+		}
+
+		cow& operator=(const T& v) { assign(v); return *this; }
+		cow& operator=(T&& v) { assign(std::move(v)); return *this; }
+
+		const T& get() const { return value ? *value : empty(); }
+		operator const T&() const { return get(); }
+		const T& operator*() const { return get(); }
+		const T* operator->() const { return &get(); }
+
+		/// <summary>
+		/// Mutable access, copying the value first if it is still shared with another scope.
+		/// </summary>
+		/// <returns>Reference to a value owned by this field alone</returns>
+		T& write() {
+			if (!value) {
+				assign(T{});
+			} else if (value.use_count() > 1) {
+				assign(static_cast<const T&>(*value));
+			}
+			return *value;
+		}
+
+		/* Whether the value is still shared with another copy */
+		bool shared() const { return value && value.use_count() > 1; }
+
+	private:
+		std::shared_ptr<T> value; /* nullptr while holding the default value */
+		std::pmr::memory_resource* resource;
+
+		template<class U>
+		void assign(U&& v) {
+			value = std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(resource), std::forward<U>(v));
+		}
+
+		static const T& empty() {
+			static const T instance{};
+			return instance;
+		}
+	};
+
+	/*
+	Sparse storage for the fields of a settings type, declared as a base: ``svh::sparse_fields<int, int, std::string>``.
+	A scope copied by push stores no values, only a link to the fields it was copied from. Setting a field stores just that field,
+	and reading resolves lazily to the nearest copy up the chain that set it, so a pushed scope that overrides
+	one field costs one field instead of a full copy of the settings.
+	A scope that is freed first copies its values into the scopes still linked to it. Any other copy or assignment
+	copies every resolved value, and moving takes over the storage.
+	*/
+	template<class... Fields>
+	struct sparse_fields {
+		static constexpr std::size_t field_count = sizeof...(Fields);
+		static_assert(field_count <= 64, "sparse_fields supports up to 64 fields");
+
+		template<std::size_t I>
+		using field_type = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+		/* All fields hold their value-initialized default */
+		sparse_fields() : resource(detail::current_resource()) {}
+
+		/* All fields are set to the given defaults */
+		explicit sparse_fields(const Fields&... defaults) : resource(detail::current_resource()) {
+			set_all(std::index_sequence_for<Fields...>{}, defaults...);
+		}
+
+		sparse_fields(const sparse_fields& other) : resource(detail::current_resource()) {
+			if (detail::links_to(&other)) {
+				link(other);
+			} else {
+				copy_resolved(other, std::index_sequence_for<Fields...>{});
+			}
+		}
+
+		sparse_fields(sparse_fields&& other) : resource(detail::current_resource()) {
+			if (resource == other.resource) {
+				if (other.base) {
+					link(*other.base);
+					other.unlink();
+				}
+				std::swap(block, other.block);
+				std::swap(mask, other.mask);
+				std::swap(constructed, other.constructed);
+			} else {
+				copy_resolved(other, std::index_sequence_for<Fields...>{});
+			}
+
+			/* Copies of other now resolve through this one */
+			copies = other.copies;
+			other.copies = nullptr;
+			for (sparse_fields* copy = copies; copy; copy = copy->next_copy) {
+				copy->base = this;
+			}
+		}
+
+		/* Copies the resolved values, scopes linked to this one keep their link and see the new values */
+		sparse_fields& operator=(const sparse_fields& other) {
+			if (this != &other) {
+				sparse_fields copy;
+				copy.copy_resolved(other, std::index_sequence_for<Fields...>{});
+				unlink();
+				release();
+				std::swap(block, copy.block);
+				std::swap(mask, copy.mask);
+				std::swap(constructed, copy.constructed);
+				std::swap(resource, copy.resource);
+			}
+			return *this;
+		}
+
+		~sparse_fields() {
+			if (!detail::tree_teardown()) {
+				detach_copies();
+				unlink();
+			}
+			release();
+		}
+
+		/// <summary>
+		/// Value of field I, from this scope or the nearest one it was copied from that set it.
+		/// </summary>
+		template<std::size_t I>
+		const field_type<I>& field() const {
+			const sparse_fields* current = this;
+			while (!(current->constructed & bit(I))) {
+				if (!current->base) {
+					return default_value<I>();
+				}
+				current = current->base;
+			}
+			return *static_cast<const field_type<I>*>(current->slot(I, current->mask));
+		}
+
+		/// <summary>
+		/// Override field I in this scope only.
+		/// </summary>
+		template<std::size_t I, class V>
+		void set_field(V&& value) {
+			if (constructed & bit(I)) {
+				*static_cast<field_type<I>*>(slot(I, mask)) = std::forward<V>(value);
+				return;
+			}
+			if (!(mask & bit(I))) {
+				grow(mask | bit(I));
+			}
+			::new (slot(I, mask)) field_type<I>(std::forward<V>(value));
+			constructed |= bit(I);
+		}
+
+		/* Whether field I is stored in this scope */
+		template<std::size_t I>
+		bool overrides() const {
+			return (constructed & bit(I)) != 0;
+		}
+
+		/* Bytes of field values stored by this scope, not counting the ones it links to */
+		std::size_t stored_bytes() const {
+			return block_size(mask);
+		}
+
+	private:
+		/* Type erased layout and operations, indexed by field */
+		static constexpr std::size_t sizes[] = { sizeof(Fields)... };
+		static constexpr std::size_t aligns[] = { alignof(Fields)... };
+
+		template<class F>
+		static void move_field(void* to, void* from) { /* Move construct into to and destroy from */
+			::new (to) F(std::move(*static_cast<F*>(from)));
+			static_cast<F*>(from)->~F();
+		}
+
+		template<class F>
+		static void destroy_field(void* p) {
+			static_cast<F*>(p)->~F();
+		}
+
+		static constexpr void (*movers[])(void*, void*) = { &move_field<Fields>... };
+		static constexpr void (*destroyers[])(void*) = { &destroy_field<Fields>... };
+
+		static constexpr std::size_t block_align() {
+			std::size_t result = alignof(std::max_align_t);
+			for (std::size_t a : aligns) {
+				result = a > result ? a : result;
+			}
+			return result;
+		}
+
+		static constexpr std::uint64_t bit(std::size_t i) {
+			return std::uint64_t{ 1 } << i;
+		}
+
+		static std::size_t align_up(std::size_t offset, std::size_t align) {
+			return (offset + align - 1) / align * align;
+		}
+
+		/* Index of the lowest set bit */
+		static std::size_t lowest(std::uint64_t bits) {
+			std::size_t i = 0;
+			while (!(bits & 1)) {
+				bits >>= 1;
+				++i;
+			}
+			return i;
+		}
+
+		/* Fields present in fields_mask are packed in index order */
+		static std::size_t offset(std::size_t i, std::uint64_t fields_mask) {
+			std::size_t result = 0;
+			for (std::uint64_t before = fields_mask & (bit(i) - 1); before; before &= before - 1) {
+				const std::size_t j = lowest(before);
+				result = align_up(result, aligns[j]) + sizes[j];
+			}
+			return align_up(result, aligns[i]);
+		}
+
+		static std::size_t block_size(std::uint64_t fields_mask) {
+			std::size_t result = 0;
+			for (std::uint64_t remaining = fields_mask; remaining; remaining &= remaining - 1) {
+				const std::size_t j = lowest(remaining);
+				result = align_up(result, aligns[j]) + sizes[j];
+			}
+			return result;
+		}
+
+		void* slot(std::size_t i, std::uint64_t fields_mask) const {
+			return block + offset(i, fields_mask);
+		}
+
+		/* Reallocate the block for new_mask, moving every constructed field over */
+		void grow(std::uint64_t new_mask) {
+			char* new_block = static_cast<char*>(resource->allocate(block_size(new_mask), block_align()));
+			for (std::uint64_t remaining = constructed; remaining; remaining &= remaining - 1) {
+				const std::size_t j = lowest(remaining);
+				movers[j](new_block + offset(j, new_mask), slot(j, mask));
+			}
+			if (block) {
+				resource->deallocate(block, block_size(mask), block_align());
+			}
+			block = new_block;
+			mask = new_mask;
+		}
+
+		void release() {
+			for (std::uint64_t remaining = constructed; remaining; remaining &= remaining - 1) {
+				const std::size_t j = lowest(remaining);
+				destroyers[j](slot(j, mask));
+			}
+			if (block) {
+				resource->deallocate(block, block_size(mask), block_align());
+			}
+			block = nullptr;
+			mask = 0;
+			constructed = 0;
+		}
+
+		void link(const sparse_fields& to) {
+			base = &to;
+			next_copy = to.copies;
+			if (next_copy) {
+				next_copy->previous_copy = this;
+			}
+			to.copies = this;
+		}
+
+		void unlink() {
+			if (!base) {
+				return;
+			}
+			if (previous_copy) {
+				previous_copy->next_copy = next_copy;
+			} else {
+				base->copies = next_copy;
+			}
+			if (next_copy) {
+				next_copy->previous_copy = previous_copy;
+			}
+			base = nullptr;
+			next_copy = nullptr;
+			previous_copy = nullptr;
+		}
+
+		/* Store the values every linked copy still reads from this one, before it is freed */
+		void detach_copies() {
+			while (copies) {
+				sparse_fields* copy = copies;
+				copy->store_resolved(std::index_sequence_for<Fields...>{});
+				copy->unlink();
+			}
+		}
+
+		template<std::size_t... I>
+		void store_resolved(std::index_sequence<I...>) {
+			((constructed & bit(I) ? void() : set_field<I>(field<I>())), ...);
+		}
+
+		template<std::size_t... I>
+		void set_all(std::index_sequence<I...>, const Fields&... values) {
+			grow((bit(I) | ...));
+			((::new (slot(I, mask)) Fields(values), constructed |= bit(I)), ...);
+		}
+
+		template<std::size_t... I>
+		void copy_resolved(const sparse_fields& other, std::index_sequence<I...>) {
+			(set_field<I>(other.template field<I>()), ...);
+		}
+
+		template<std::size_t I>
+		static const field_type<I>& default_value() {
+			static const field_type<I> instance{};
+			return instance;
+		}
+
+		const sparse_fields* base = nullptr; /* Fields this one was copied from */
+		mutable sparse_fields* copies = nullptr; /* First of the scopes linked to this one */
+		sparse_fields* next_copy = nullptr;      /* Siblings linked to the same base */
+		sparse_fields* previous_copy = nullptr;
+		char* block = nullptr;               /* Values of the fields in mask */
+		std::uint64_t mask = 0;              /* Fields with storage in block */
+		std::uint64_t constructed = 0;       /* Fields holding a value, only differs from mask if a constructor threw */
+		std::pmr::memory_resource* resource;
+	};
+}
+
+namespace svh {
+
+	/* Name and member pointer of one reflected field, see ``reflect`` */
+	template<class Owner, class T>
+	struct field_info {
+		using value_type = T;
+
+		const char* name;
+		T Owner::* pointer;
+	};
+
+	template<class Owner, class T>
+	constexpr field_info<Owner, T> field(const char* name, T Owner::* pointer) {
+		return { name, pointer };
+	}
+
+	/*
+	Fields of a settings type that are saved and loaded, e.g. by ``save_binary``. Specialize it for settings that should carry data:
+	template<> struct svh::reflect<type_settings<int>> {
+		static constexpr auto fields = std::make_tuple(svh::field("min", &type_settings<int>::_min), svh::field("max", &type_settings<int>::_max));
+	};
+	Settings without a specialization are saved as their place in the tree only.
+	*/
+	template<class Settings>
+	struct reflect {
+		static constexpr std::tuple<> fields{};
+	};
+
+	namespace detail {
+		template<class A, class B>
+		constexpr bool same_member(A a, B b) {
+			if constexpr (std::is_same_v<A, B>) {
+				return a == b;
+			} else {
+				return false;
+			}
+		}
+
+		template<class Fields, std::size_t I>
+		using field_value_t = typename std::tuple_element_t<I, Fields>::value_type;
+
+		/* Offset of every field, each at its natural alignment, followed by the packed size */
+		template<class Fields, std::size_t... I>
+		constexpr std::array<std::size_t, sizeof...(I) + 1> packed_offsets(std::index_sequence<I...>) {
+			std::array<std::size_t, sizeof...(I) + 1> offsets{};
+			std::size_t at = 0;
+			((at = (at + alignof(field_value_t<Fields, I>) - 1) / alignof(field_value_t<Fields, I>) * alignof(field_value_t<Fields, I>),
+				offsets[I] = at,
+				at += sizeof(field_value_t<Fields, I>)), ...);
+			offsets[sizeof...(I)] = at;
+			return offsets;
+		}
+
+		template<class Fields, std::size_t... I>
+		constexpr std::size_t packed_align(std::index_sequence<I...>) {
+			std::size_t align = 1;
+			((align = alignof(field_value_t<Fields, I>) > align ? alignof(field_value_t<Fields, I>) : align), ...);
+			return align;
+		}
+
+		template<auto Member, class Fields, std::size_t... I>
+		constexpr std::size_t field_index(const Fields& fields, std::index_sequence<I...>) {
+			std::size_t index = sizeof...(I);
+			((index = same_member(std::get<I>(fields).pointer, Member) ? I : index), ...);
+			return index;
+		}
+
+		/*
+		The reflected fields of Settings packed one after another at their natural alignment, as stored in saved trees.
+		Only trivially copyable fields can be packed, so the bytes can be used in place once loaded.
+		*/
+		template<class Settings>
+		struct payload {
+			using fields_type = std::decay_t<decltype(reflect<Settings>::fields)>;
+			using sequence = std::make_index_sequence<std::tuple_size_v<fields_type>>;
+
+			template<std::size_t I>
+			using field_type = field_value_t<fields_type, I>;
+
+			static constexpr std::size_t count = std::tuple_size_v<fields_type>;
+			static constexpr std::array<std::size_t, count + 1> offsets = packed_offsets<fields_type>(sequence{});
+			static constexpr std::size_t size = offsets[count];
+			static constexpr std::size_t align = packed_align<fields_type>(sequence{});
+
+			/* Index of the field with this member pointer, count if it is not reflected */
+			template<auto Member>
+			static constexpr std::size_t index_of() {
+				return field_index<Member>(reflect<Settings>::fields, sequence{});
+			}
+
+			/* Changes with the names, sizes and order of the fields, so a saved payload is only read back into the same layout */
+			static std::uint64_t signature() {
+				return signature(sequence{});
+			}
+
+			static void write(const Settings& settings, unsigned char* out) {
+				write(settings, out, sequence{});
+			}
+
+			static void read(const unsigned char* in, Settings& settings) {
+				read(in, settings, sequence{});
+			}
+
+		private:
+			template<std::size_t... I>
+			static std::uint64_t signature(std::index_sequence<I...>) {
+				std::uint64_t hash = fnv1a(static_cast<std::uint64_t>(count), 0xcbf29ce484222325ULL);
+				((hash = fnv1a(std::get<I>(reflect<Settings>::fields).name, fnv1a(static_cast<std::uint64_t>(sizeof(field_type<I>)), fnv1a(static_cast<std::uint64_t>(offsets[I]), hash)))), ...);
+				return hash;
+			}
+
+			template<std::size_t... I>
+			static void write(const Settings& settings, unsigned char* out, std::index_sequence<I...>) {
+				(void)settings;
+				(void)out;
+				static_assert((std::is_trivially_copyable_v<field_type<I>> && ...), "Reflected fields must be trivially copyable to be saved");
+				(std::memcpy(out + offsets[I], &(settings.*std::get<I>(reflect<Settings>::fields).pointer), sizeof(field_type<I>)), ...);
+			}
+
+			template<std::size_t... I>
+			static void read(const unsigned char* in, Settings& settings, std::index_sequence<I...>) {
+				(void)in;
+				(void)settings;
+				(std::memcpy(&(settings.*std::get<I>(reflect<Settings>::fields).pointer), in + offsets[I], sizeof(field_type<I>)), ...);
+			}
+		};
+	}
+
+	template<template<class> class BaseTemplate>
+	struct frozen_scope; // Forward declare
+
+	namespace detail {
+		template<template<class> class BaseTemplate>
+		struct binary_format; // Forward declare, see scope_binary.hpp
+
+		template<template<class> class BaseTemplate>
+		struct json_format; // Forward declare, see scope_json.hpp
+	}
+
+	template<template<class> class BaseTemplate>
+	class versioned_scope; // Forward declare
+
+	template<template<class> class BaseTemplate>
+	struct scope {
+	private:
+		struct member_id; // Forward declare
+		friend struct frozen_scope<BaseTemplate>;
+		friend class versioned_scope<BaseTemplate>;
+		friend struct detail::binary_format<BaseTemplate>;
+		friend struct detail::json_format<BaseTemplate>;
+	public:
+
+		virtual ~scope() { // Virtual for dynamic_cast
+			detail::teardown_scope teardown(parent == nullptr); /* Every node goes, so sparse_fields need not detach from each other */
+			release_table(tables);
+			release_table(resolve_cache);
+		}
+		scope() = default;
+
+		/// <summary>
+		/// Create a root scope whose nodes, maps and control blocks are all allocated from resource,
+		/// e.g. a ``std::pmr::monotonic_buffer_resource`` so the whole tree is one region released at once.
+		/// The resource must outlive the tree.
+		/// </summary>
+		/// <param name="resource">Memory resource backing the tree</param>
+		explicit scope(std::pmr::memory_resource* resource) {
+			owned_tree = std::make_unique<detail::tree_state>(resource);
+			owned_tree->root = this;
+			tree.store(owned_tree.get(), std::memory_order_release);
+		}
+
+		/* Copies only carry the settings of the derived type, never the place in a tree */
+		scope(const scope&) : scope() {}
+		scope& operator=(const scope&) { return *this; }
+
+		/// <summary>
+		/// Push a new scope for type T. If one already exists, it is returned.
+		/// Else if a parent has one, it is copied.
+		/// Else, a new one is created.
+		/// </summary>
+		/// <typeparam name="T">The type of the scope to push</typeparam>
+		/// <returns>Reference to the pushed scope</returns>
+		/// <exception cref="std::runtime_error">If an existing child has an unexpected type</exception>
+		template<class T>
+		BaseTemplate<simplify_t<T>>& push() {
+			return _push<simplify_t<T>>();
+		}
+
+		template<template<class...> class T>
+		BaseTemplate<simplify_template_t<T>>& push() {
+			return _push<simplify_template_t<T>>();
+		}
+
+		/// <summary>
+		/// Push multiple scopes in order.
+		/// </summary>
+		/// <typeparam name="T">First types</typeparam>
+		/// <typeparam name="U">Second type</typeparam>
+		/// <typeparam name="...Rest">Chain other Types</typeparam>
+		/// <returns>Reference to the last pushed scope</returns>
+		template<class T, class U, class... Rest>
+		auto& push() {
+			auto& next = _push<simplify_t<T>>();
+			/* If rest is something, we recurse */
+			/* If rest is nothing, we fall back to single T push */
+			return next.template push<simplify_t<U>, Rest...>();
+		}
+
+		/// <summary>
+		/// Push a new scope for type T with default values.
+		/// </summary>
+		/// <typeparam name="T">The type of the scope to push</typeparam>
+		/// <returns>Reference to the pushed scope</returns>
+		/// <exception cref="std::runtime_error">If an existing child has an unexpected type</exception>
+		template<class T>
+		BaseTemplate<simplify_t<T>>& push_default() {
+			const type_id key = get_type_key<simplify_t<T>>();
+			detail::write_guard lock(state());
+
+			/* reset if present */
+			if (scope* existing = find_child(key)) {
+				auto* found = downcast<simplify_t<T>>(existing);
+				if (!found) {
+					detail::raise("Existing child has unexpected type");
+				}
+				detail::construction_scope construction(state().resource);
+				*found = BaseTemplate<simplify_t<T>>{}; // Reset to default, keeps its place in the tree
+				found->release_table(found->tables);
+				invalidate_cache();
+				return *found;
+			}
+
+			/* Else create new */
+			return emplace_new<simplify_t<T>>();
+		}
+
+		/// <summary>
+		/// Push member settings. Creates new or returns existing.
+		/// </summary>
+		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
+		/// <returns>Reference to member settings</returns>
+		template<auto member>
+		auto& push_member() {
+			using MemberType = typename member_pointer_traits<decltype(member)>::member_type;
+
+			const auto& key = member_key<member>().key;
+			detail::write_guard lock(state());
+
+			// Check if already exists in current scope
+			if (scope* existing = find_member_child(key, member_key<member>().hash)) {
+				auto* found = downcast<MemberType>(existing);
+				if (!found) {
+					detail::raise("Existing member child has unexpected type");
+				}
+				return *found;
+			}
+
+			// Look for existing in parent to copy
+			if (has_parent()) {
+				auto* found = find_member<member>();
+				if (found) {
+					detail::linked_copy_scope link(found, sizeof(*found));
+					auto& child = emplace_member<MemberType>(member_key<member>(), *found);
+					child.active_member = key;
+					record(trace_kind::push_copy, key.member_type);
+					return child;
+				}
+			}
+
+			// Create new
+			auto& child = emplace_member<MemberType>(member_key<member>());
+			child.active_member = key;
+			return child;
+		}
+
+		/// <summary>
+		/// Pop to parent scope. Throws if at root.
+		/// </summary>
+		/// <returns>Reference to the parent scope</returns>
+		/// <exception cref="std::runtime_error">If at root</exception>
+		scope& pop(int count = 1) const {
+			const scope* current = this;
+			for (; count > 0; --count) {
+				if (!current->has_parent()) {
+					detail::raise("No parent to pop to");
+				}
+				current = current->parent;
+			}
+			return const_cast<scope&>(*current);
+		}
+
+		scope& pop_to_root() {
+			return *static_cast<scope*>(state().root);
+		}
+
+		/// <summary>
+		/// Get the scope for type T. If not found, recurse to parent.
+		/// If not found and at root, optionally insert a default one depending on ``SVH_AUTO_INSERT``.
+		/// </summary>
+		/// <typeparam name="T">The type of the scope to get</typeparam>
+		/// <returns>Reference to the found scope</returns>
+		/// <exception cref="std::runtime_error">If not found and at root and ``SVH_AUTO_INSERT`` is false</exception>
+		template <class T>
+		BaseTemplate<simplify_t<T>>& get() {
+			return _get<simplify_t<T>>();
+		}
+
+		template<template<class...> class T>
+		BaseTemplate<simplify_template_t<T>>& get() {
+			return _get<simplify_template_t<T>>();
+		}
+
+		template <class T, class U, class... Rest>
+		auto& get() {
+			auto& next = _get<simplify_t<T>>();
+			/* If rest is something, we recurse */
+			/* If rest is nothing, we fall back to single T get */
+			return next.template get<simplify_t<U>, Rest...>();
+		}
+
+		/// <summary>
+		/// Get the scope for type T. If not found, recurse to parent.
+		/// If not found and at root, throw.
+		/// </summary>
+		/// <typeparam name="T">The type of the scope to get</typeparam>
+		/// <returns>Reference to the found scope</returns>
+		/// <exception cref="std::runtime_error">If not found</exception>
+		template <class T>
+		const BaseTemplate<simplify_t<T>>& get() const {
+			return _get<simplify_t<T>>();
+		}
+
+		template <class T, class U, class... Rest>
+		const auto& get() const {
+			auto& next = _get<simplify_t<T>>();
+			/* If rest is something, we recurse */
+			/* If rest is nothing, we fall back to single T get */
+			return next.template get<simplify_t<U>, Rest...>();
+		}
+
+		/// Get member settings. Auto-creates if not found at root level.
+		/// </summary>
+		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
+		/// <returns>Reference to member settings</returns>
+		template<auto member>
+		auto& get_member() {
+			auto* found = find_member<member>();
+			if (found) {
+				return *found;
+			}
+
+			if (SVH_AUTO_INSERT) {
+				return push_member<member>(); /* Rechecks under the write lock, in case another thread inserted it meanwhile */
+			}
+
+			detail::raise("Member settings not found");
+		}
+
+		/// Get member settings (const version).
+		/// </summary>
+		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
+		/// <returns>Const reference to member settings</returns>
+		template<auto member>
+		const auto& get_member() const {
+			auto* found = find_member<member>();
+			if (found) {
+				return *found;
+			}
+
+			detail::raise("Member settings not found");
+		}
+
+
+		/// <summary>
+		/// Find the scope for type T. If not found, recurse to parent.
+		/// If not found and at root, return nullptr.
+		/// </summary>
+		/// <typeparam name="T">The type of the scope to find</typeparam>
+		/// <returns>Pointer to the found scope or nullptr if not found</returns>
+		/// <exception cref="std::runtime_error">If an existing child has an unexpected type</exception>
+		template <class T>
+		BaseTemplate<T>* find(const member_id& child_member_id = {}) const {
+			detail::read_guard lock(state());
+			if (child_member_id.is_valid()) {
+				return checked(typed<T>(find_node(get_type_key<T>(), child_member_id)), "Existing member child has unexpected type");
+			}
+			scope* found = find_cached(get_type_key<T>());
+			record_lookup(get_type_key<T>(), found);
+			return checked(typed<T>(found));
+		}
+
+		/// <summary>
+		/// Find the scopes for several types at once. The parents are walked a single time for all of them,
+		/// stopping as soon as every type is resolved. Each result is the same as find&lt;T&gt;().
+		/// </summary>
+		/// <typeparam name="Ts">The types of the scopes to find</typeparam>
+		/// <returns>Pointers to the found scopes in argument order, nullptr for types not found</returns>
+		/// <exception cref="std::runtime_error">If an existing child has an unexpected type</exception>
+		template <class... Ts>
+		std::tuple<BaseTemplate<simplify_t<Ts>>*...> find_all() const {
+			detail::read_guard lock(state());
+			const std::array<type_id, sizeof...(Ts)> keys{ get_type_key<simplify_t<Ts>>()... };
+			std::array<scope*, sizeof...(Ts)> found{};
+			find_cached_nodes(keys, found);
+			for (std::size_t i = 0; i < keys.size(); ++i) {
+				record_lookup(keys[i], found[i]);
+			}
+			return typed_all<simplify_t<Ts>...>(found, std::index_sequence_for<Ts...>{});
+		}
+
+		/// <summary>
+		/// Get the scopes for several types at once, e.g. get_all&lt;int, float, bool&gt;().
+		/// Resolves like find_all and creates the missing types like get&lt;T&gt;().
+		/// </summary>
+		/// <typeparam name="Ts">The types of the scopes to get</typeparam>
+		/// <returns>References to the scopes in argument order</returns>
+		/// <exception cref="std::runtime_error">If a type is not found and ``SVH_AUTO_INSERT`` is false</exception>
+		template <class... Ts>
+		std::tuple<BaseTemplate<simplify_t<Ts>>&...> get_all() {
+			return std::apply([this](auto*... found) {
+				return std::tuple<BaseTemplate<simplify_t<Ts>>&...>{ found_or_get(found)... };
+			}, find_all<Ts...>());
+		}
+
+		/// <summary>
+		/// Get the scopes for several types at once (const version).
+		/// </summary>
+		/// <typeparam name="Ts">The types of the scopes to get</typeparam>
+		/// <returns>Const references to the scopes in argument order</returns>
+		/// <exception cref="std::runtime_error">If a type is not found</exception>
+		template <class... Ts>
+		std::tuple<const BaseTemplate<simplify_t<Ts>>&...> get_all() const {
+			return std::apply([this](auto*... found) {
+				return std::tuple<const BaseTemplate<simplify_t<Ts>>&...>{ found_or_get(found)... };
+			}, find_all<Ts...>());
+		}
+
+		/// <summary>
+		/// Find member settings. Returns nullptr if not found.
+		/// </summary>
+		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
+		/// <returns>Pointer to member settings or nullptr if not found</returns>
+		template<auto member>
+		auto* find_member() const {
+			using MemberType = typename member_pointer_traits<decltype(member)>::member_type;
+			detail::read_guard lock(state());
+
+			const static_member_key& cached = member_key<member>();
+			return checked(typed<MemberType>(find_member_node(cached.key, cached.hash)), "Existing member child has unexpected type");
+		}
+
+		/// <summary>
+		/// Find member settings using runtime instance and member reference.
+		/// </summary>
+		/// <typeparam name="T">Parent class type</typeparam>
+		/// <typeparam name="M">Member type</typeparam>
+		/// <param name="instance">Instance containing the member</param>
+		/// <param name="member">Reference to the specific member</param>
+		/// <returns>Pointer to member settings or nullptr if not found</returns>
+		template<class T, class M>
+		BaseTemplate<M>* find_member_runtime(const T& instance, const M& member) const {
+			detail::read_guard lock(state());
+			return checked(find_member_offset<T, M>(runtime_offset(instance, member)), "Existing member child has unexpected type");
+		}
+
+		/// <summary>
+		/// Get member settings using runtime instance and member reference.
+		/// </summary>
+		/// <typeparam name="T">Parent class type</typeparam>
+		/// <typeparam name="M">Member type</typeparam>
+		/// <param name="instance">Instance containing the member</param>
+		/// <param name="member">Reference to the specific member</param>
+		/// <returns>Reference to member settings</returns>
+		template<class T, class M>
+		BaseTemplate<M>& get_member(const T& instance, const M& member) {
+			auto* found = find_member_runtime(instance, member);
+			if (found) {
+				return *found;
+			}
+
+			if (SVH_AUTO_INSERT) {
+				detail::write_guard lock(state());
+				found = find_member_runtime(instance, member); /* Another thread may have inserted it meanwhile */
+				if (found) {
+					return *found;
+				}
+
+				// Create new member settings at runtime
+				const auto key = member_id{ get_type_key<T>(), get_type_key<M>(), runtime_offset(instance, member) };
+
+				record(trace_kind::auto_insert, key.member_type);
+				return emplace_member<M>(static_member_key{ key, member_key_hash{}(key), layout_of<T, M>() });
+			}
+
+			detail::raise("Member settings not found");
+		}
+
+		/// <summary>
+		/// Get member settings using runtime instance and member reference (const version).
+		/// </summary>
+		/// <typeparam name="T">Parent class type</typeparam>
+		/// <typeparam name="M">Member type</typeparam>
+		/// <param name="instance">Instance containing the member</param>
+		/// <param name="member">Reference to the specific member</param>
+		/// <returns>Const reference to member settings</returns>
+		template<class T, class M>
+		const BaseTemplate<M>& get_member(const T& instance, const M& member) const {
+			auto* found = find_member_runtime(instance, member);
+			if (found) {
+				return *found;
+			}
+
+			detail::raise("Member settings not found");
+		}
+
+		/// <summary>
+		/// Find the settings of several members of one instance in one call, e.g. every field an inspector shows.
+		/// The tree is locked once for all members.
+		/// </summary>
+		/// <typeparam name="T">Parent class type</typeparam>
+		/// <typeparam name="M">Member types</typeparam>
+		/// <param name="instance">Instance containing the members</param>
+		/// <param name="members">References to the members</param>
+		/// <returns>Pointers to the member settings in argument order, nullptr for members without settings</returns>
+		template<class T, class... M>
+		std::tuple<BaseTemplate<M>*...> find_members(const T& instance, const M&... members) const {
+			detail::read_guard lock(state());
+			return std::tuple<BaseTemplate<M>*...>{ checked(find_member_offset<T, M>(runtime_offset(instance, members)), "Existing member child has unexpected type")... };
+		}
+
+		/// <summary>
+		/// Get the settings of several members of one instance in one call, see find_members.
+		/// </summary>
+		/// <typeparam name="T">Parent class type</typeparam>
+		/// <typeparam name="M">Member types</typeparam>
+		/// <param name="instance">Instance containing the members</param>
+		/// <param name="members">References to the members</param>
+		/// <returns>References to the member settings in argument order</returns>
+		template<class T, class... M>
+		std::tuple<BaseTemplate<M>&...> get_members(const T& instance, const M&... members) {
+			return std::tuple<BaseTemplate<M>&...>{ get_member(instance, members)... };
+		}
+
+		/// <summary>
+		/// Get the settings of several members of one instance in one call (const version).
+		/// </summary>
+		/// <typeparam name="T">Parent class type</typeparam>
+		/// <typeparam name="M">Member types</typeparam>
+		/// <param name="instance">Instance containing the members</param>
+		/// <param name="members">References to the members</param>
+		/// <returns>Const references to the member settings in argument order</returns>
+		template<class T, class... M>
+		std::tuple<const BaseTemplate<M>&...> get_members(const T& instance, const M&... members) const {
+			return std::tuple<const BaseTemplate<M>&...>{ get_member(instance, members)... };
+		}
+
+		/// <summary>
+		/// Find the scope for type T like get, but never insert, throw or abort.
+		/// Meant for probing optional settings in hot loops.
+		/// </summary>
+		/// <typeparam name="T">The type of the scope to get</typeparam>
+		/// <returns>The scope, or the reason there is none</returns>
+		template <class T>
+		result<BaseTemplate<simplify_t<T>>> try_get() const {
+			detail::read_guard lock(state());
+			scope* found = find_cached(get_type_key<simplify_t<T>>());
+			record_lookup(get_type_key<simplify_t<T>>(), found);
+			return typed<simplify_t<T>>(found);
+		}
+
+		template <class T, class U, class... Rest>
+		auto try_get() const {
+			auto next = try_get<T>();
+			using result_type = decltype(next->template try_get<U, Rest...>());
+			if (!next) {
+				return result_type::failure(next.error());
+			}
+			return next->template try_get<U, Rest...>();
+		}
+
+		/// <summary>
+		/// Find member settings like get_member, but never insert, throw or abort.
+		/// </summary>
+		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
+		/// <returns>The member settings, or the reason there are none</returns>
+		template<auto member>
+		auto try_get_member() const {
+			using MemberType = typename member_pointer_traits<decltype(member)>::member_type;
+			detail::read_guard lock(state());
+
+			const static_member_key& cached = member_key<member>();
+			return typed<MemberType>(find_member_node(cached.key, cached.hash));
+		}
+
+		/// <summary>
+		/// Find member settings using runtime instance and member reference, but never insert, throw or abort.
+		/// </summary>
+		/// <typeparam name="T">Parent class type</typeparam>
+		/// <typeparam name="M">Member type</typeparam>
+		/// <param name="instance">Instance containing the member</param>
+		/// <param name="member">Reference to the specific member</param>
+		/// <returns>The member settings, or the reason there are none</returns>
+		template<class T, class M>
+		result<BaseTemplate<M>> try_get_member(const T& instance, const M& member) const {
+			detail::read_guard lock(state());
+			return find_member_offset<T, M>(runtime_offset(instance, member));
+		}
+
+		/// <summary>
+		/// Push a scope for type T like push, but report a type mismatch instead of throwing.
+		/// </summary>
+		/// <typeparam name="T">The type of the scope to push</typeparam>
+		/// <returns>The pushed scope, or the reason it could not be pushed</returns>
+		template<class T>
+		result<BaseTemplate<simplify_t<T>>> try_push() {
+			return _try_push<simplify_t<T>>();
+		}
+
+		template<class T, class U, class... Rest>
+		auto try_push() {
+			auto next = _try_push<simplify_t<T>>();
+			using result_type = decltype(next->template try_push<U, Rest...>());
+			if (!next) {
+				return result_type::failure(next.error());
+			}
+			return next->template try_push<U, Rest...>();
+		}
+
+		/// <summary>
+		/// Flatten this scope and everything reachable from it into an immutable snapshot.
+		/// Every (scope, type) resolution, including the fallback to parents, is precomputed,
+		/// so lookups on the snapshot are a single table load without hashing, RTTI or recursion.
+		/// The snapshot points into this tree, which must outlive it and must not be mutated while it is used.
+		/// </summary>
+		/// <returns>The frozen snapshot rooted at this scope</returns>
+		frozen_scope<BaseTemplate> freeze() const {
+			detail::read_guard lock(state());
+			return frozen_scope<BaseTemplate>(*this);
+		}
+
+		/// <summary>
+		/// Hit and miss counters of the resolution cache, shared by the whole tree.
+		/// </summary>
+		/// <returns>The counters since creation or the last reset</returns>
+		resolve_stats cache_stats() const {
+			return state().stats;
+		}
+
+		void reset_cache_stats() {
+			state().stats = {};
+		}
+
+		/// <summary>
+		/// Lookup, auto-insert and push copy counters of the whole tree, per type and per scope the calls were made on.
+		/// Only recorded with ``SVH_INSTRUMENT``, empty otherwise.
+		/// </summary>
+		/// <returns>The counters since creation or the last reset</returns>
+		lookup_report lookup_stats() const {
+			return detail::report(state().instruments);
+		}
+
+		void reset_lookup_stats() {
+			detail::reset(state().instruments);
+		}
+
+		/// <summary>
+		/// Debug log the scope tree to console.
+		/// </summary>
+		/// <param name="indent">Indentation level</param>
+		void debug_log(int indent = 0) const {
+			dump_options options;
+			options.margin = static_cast<std::size_t>(indent);
+			dump(std::cout, options);
+		}
+
+		/// <summary>
+		/// Write the tree below this scope as text, one line per scope, without allocating per scope.
+		/// Types are written with their ``type_name``, members as ``Struct::(offset N) -> Member``.
+		/// </summary>
+		/// <param name="sink">Called with consecutive pieces of the text as std::string_view</param>
+		/// <param name="options">Depth limit and indentation</param>
+		/// <param name="filter">Called with a dump_entry per scope, returning false skips the scope and its subtree</param>
+		template<class Sink, class Filter = dump_all, std::enable_if_t<std::is_invocable_v<Sink&, std::string_view>, int> = 0>
+		void dump(Sink&& sink, const dump_options& options = {}, Filter filter = {}) const {
+			detail::read_guard lock(state());
+
+			/* Children left to visit per level. Trees up to inline_depth levels deep are walked on the stack */
+			struct frame {
+				const scope* node;
+				std::size_t child;
+				std::size_t member;
+			};
+			constexpr std::size_t inline_depth = 64;
+			alignas(frame) std::byte storage[inline_depth * sizeof(frame)];
+			std::pmr::monotonic_buffer_resource arena(storage, sizeof(storage));
+			std::pmr::vector<frame> stack(&arena);
+			stack.reserve(inline_depth);
+			stack.push_back({ this, 0, 0 });
+
+			char fill[64];
+			std::memset(fill, options.indent_char, sizeof(fill));
+			char number[24];
+
+			while (!stack.empty()) {
+				frame& top = stack.back();
+				const child_tables& tables = top.node->view();
+				const std::size_t depth = stack.size();
+				dump_entry entry{ type_id{}, type_id{}, 0, depth };
+				const scope* next;
+				if (top.child < tables.children.size()) {
+					const auto& pair = *(tables.children.begin() + top.child++);
+					entry.type = pair.first;
+					next = pair.second.get();
+				} else if (top.member < tables.member_children.size()) {
+					const auto& pair = *(tables.member_children.begin() + top.member++);
+					entry.type = pair.first.member_type;
+					entry.struct_type = pair.first.struct_type;
+					entry.offset = pair.first.offset;
+					next = pair.second.get();
+				} else {
+					stack.pop_back();
+					continue;
+				}
+
+				if (!filter(static_cast<const dump_entry&>(entry))) {
+					continue;
+				}
+
+				for (std::size_t pad = options.margin + options.indent * (depth - 1); pad > 0;) {
+					const std::size_t chunk = pad < sizeof(fill) ? pad : sizeof(fill);
+					sink(std::string_view(fill, chunk));
+					pad -= chunk;
+				}
+				if (entry.is_member()) {
+					const char* end = std::to_chars(number, number + sizeof(number), entry.offset).ptr;
+					sink(entry.struct_type.name());
+					sink(std::string_view("::(offset "));
+					sink(std::string_view(number, static_cast<std::size_t>(end - number)));
+					sink(std::string_view(") -> "));
+				}
+				sink(entry.type.name());
+				sink(std::string_view("\n"));
+
+				if (depth < options.max_depth) {
+					stack.push_back({ next, 0, 0 });
+				}
+			}
+		}
+
+		/// <summary>
+		/// Write the tree below this scope to a stream, in large chunks.
+		/// </summary>
+		template<class Filter = dump_all>
+		void dump(std::ostream& out, const dump_options& options = {}, Filter filter = {}) const {
+			char chunk[4096];
+			std::size_t used = 0;
+			dump([&](std::string_view text) {
+				if (text.size() > sizeof(chunk) - used) {
+					out.write(chunk, static_cast<std::streamsize>(used));
+					used = 0;
+					if (text.size() > sizeof(chunk)) {
+						out.write(text.data(), static_cast<std::streamsize>(text.size()));
+						return;
+					}
+				}
+				std::memcpy(chunk + used, text.data(), text.size());
+				used += text.size();
+			}, options, filter);
+			out.write(chunk, static_cast<std::streamsize>(used));
+		}
+
+		/// <summary>
+		/// Write the tree below this scope into a buffer, like snprintf: the text is cut to fit and always terminated.
+		/// </summary>
+		/// <returns>Length of the whole text, a larger buffer is needed when it is not below size</returns>
+		template<class Filter = dump_all>
+		std::size_t dump(char* buffer, std::size_t size, const dump_options& options = {}, Filter filter = {}) const {
+			std::size_t length = 0;
+			dump([&](std::string_view text) {
+				if (length + 1 < size) {
+					const std::size_t room = size - 1 - length;
+					std::memcpy(buffer + length, text.data(), text.size() < room ? text.size() : room);
+				}
+				length += text.size();
+			}, options, filter);
+			if (size > 0) {
+				buffer[length < size ? length : size - 1] = '\0';
+			}
+			return length;
+		}
+	private:
+		struct member_id {
+			type_id struct_type;
+			type_id member_type;
+			std::size_t offset = std::numeric_limits<std::size_t>::max();
+
+			bool is_valid() const {
+				return struct_type.is_valid() && member_type.is_valid() && offset != std::numeric_limits<std::size_t>::max();
+			}
+
+			bool operator==(const member_id& other) const {
+				return struct_type == other.struct_type && member_type == other.member_type && offset == other.offset;
+			}
+		};
+		struct member_key_hash {
+			std::size_t operator()(const member_id& k) const {
+				return SVH_MEMBER_HASH{}(k.struct_type, k.member_type, k.offset);
+			}
+		};
+	protected:
+		struct node_ops;
+
+		/* Destroys and deallocates a child through the resource of its tree */
+		struct node_deleter {
+			const node_ops* ops;
+			void operator()(scope* child) const { ops->destroy(child); }
+		};
+
+		/* Owns a child */
+		using node_ptr = std::unique_ptr<scope, node_deleter>;
+
+		/* Operations on a child that need its settings type, recorded once per type when the child is created */
+		struct node_ops {
+			void (*destroy)(scope* child);
+			node_ptr (*clone)(scope& parent, const scope& source); /* Deep copy of source and its subtree under parent */
+
+			/* Reflected fields of the settings, see ``reflect`` */
+			std::size_t payload_size;
+			std::size_t payload_align;
+			std::uint64_t (*payload_signature)();
+			void (*save)(const scope& node, unsigned char* out);
+		};
+
+		scope* parent = nullptr; /* Root level */
+
+		/*
+		Shared tree state, created by the root on first use, so settings copied out of a tree never allocate one.
+		Atomic because concurrent readers of a new root may race to create it. Declared before the children so it outlives them
+		*/
+		mutable std::atomic<detail::tree_state*> tree{ nullptr };
+		mutable std::unique_ptr<detail::tree_state> owned_tree;
+
+		/* Children of a scope, allocated with its first child so leaves only carry a null pointer */
+		struct child_tables {
+			explicit child_tables(std::pmr::memory_resource* resource) : children(resource), member_children(resource) {}
+
+			/* type -> scope */
+			detail::flat_map<type_id, node_ptr, type_id_hash> children;
+			/* (struct type + member type + offset) -> scope */
+			detail::flat_map<member_id, node_ptr, member_key_hash> member_children;
+		};
+		child_tables* tables = nullptr;
+
+		member_id active_member;
+
+		/* Id of T for BaseTemplate<T>, recorded when the scope is created */
+		type_id type_tag;
+
+		/* type -> resolved scope, valid while the entry generation matches the tree */
+		struct cache_entry {
+			scope* found = nullptr;
+			std::uint64_t generation = 0;
+		};
+		using cache_table = detail::flat_map<type_id, cache_entry, type_id_hash>;
+		mutable cache_table* resolve_cache = nullptr; /* Allocated with the first cached lookup */
+
+		detail::tree_state& state() const {
+			if (detail::tree_state* current = tree.load(std::memory_order_acquire)) {
+				return *current;
+			}
+			return create_state();
+		}
+
+		/* Children are adopted into the state of their parent, so only roots get here. The thread that loses a race frees its copy */
+		detail::tree_state& create_state() const {
+			auto created = std::make_unique<detail::tree_state>();
+			created->root = const_cast<scope*>(this);
+			detail::tree_state* expected = nullptr;
+			if (!tree.compare_exchange_strong(expected, created.get(), std::memory_order_acq_rel)) {
+				return *expected;
+			}
+			owned_tree = std::move(created);
+			return *owned_tree;
+		}
+
+		/* Allocate a table of this scope from the tree's resource */
+		template<class Table>
+		Table* allocate_table() const {
+			std::pmr::polymorphic_allocator<Table> allocator(state().resource);
+			detail::allocation_guard<Table> guard{ allocator, allocator.allocate(1) };
+			::new (static_cast<void*>(guard.pointer)) Table(allocator.resource());
+			return guard.release();
+		}
+
+		template<class Table>
+		void release_table(Table*& table) const {
+			if (!table) {
+				return;
+			}
+			std::pmr::polymorphic_allocator<Table> allocator(state().resource);
+			table->~Table();
+			allocator.deallocate(table, 1);
+			table = nullptr;
+		}
+
+		child_tables& own_tables() {
+			if (!tables) {
+				tables = allocate_table<child_tables>();
+			}
+			return *tables;
+		}
+
+		/* Children for iteration, empty for leaves */
+		const child_tables& view() const {
+			static const child_tables none(std::pmr::null_memory_resource());
+			return tables ? *tables : none;
+		}
+
+		/* Child stored in this scope for key, nullptr if none */
+		scope* find_child(const type_id& key) const {
+			if (!tables) {
+				return nullptr;
+			}
+			auto it = tables->children.find(key);
+			return it != tables->children.end() ? it->second.get() : nullptr;
+		}
+
+		scope* find_member_child(const member_id& key) const {
+			return find_member_child(key, member_key_hash{}(key));
+		}
+
+		scope* find_member_child(const member_id& key, std::size_t hash) const {
+			if (!tables) {
+				return nullptr;
+			}
+			const auto& members = tables->member_children;
+			auto it = members.find(key, hash);
+			return it != members.end() ? it->second.get() : nullptr;
+		}
+
+		/* Allocate a child holding the settings of T from the tree's resource and link it into this tree */
+		template<class T, class... Args>
+		node_ptr make_child(Args&&... args) {
+			std::pmr::polymorphic_allocator<BaseTemplate<T>> allocator(state().resource);
+			detail::construction_scope construction(allocator.resource());
+			detail::allocation_guard<BaseTemplate<T>> guard{ allocator, allocator.allocate(1) };
+			::new (static_cast<void*>(guard.pointer)) BaseTemplate<T>(std::forward<Args>(args)...);
+			BaseTemplate<T>* child = guard.release();
+			node_ptr owner(child, node_deleter{ &ops_of<T>() });
+			adopt(*child);
+			child->type_tag = type_id::of<T>();
+			return owner;
+		}
+
+		/* make_child, stored in map */
+		template<class T, class Map, class Key, class... Args>
+		BaseTemplate<T>& emplace_child(Map& map, const Key& key, Args&&... args) {
+			node_ptr owner = make_child<T>(std::forward<Args>(args)...);
+			auto& child = static_cast<BaseTemplate<T>&>(*owner);
+			map.emplace(key, std::move(owner));
+			return child;
+		}
+
+		template<class T>
+		static const node_ops& ops_of() {
+			using payload = detail::payload<BaseTemplate<T>>;
+			static const node_ops ops{ &destroy_child<T>, &clone_child<T>, payload::size, payload::align, &payload::signature, &save_child<T> };
+			return ops;
+		}
+
+		template<class T>
+		static void destroy_child(scope* child) {
+			std::pmr::polymorphic_allocator<BaseTemplate<T>> allocator(child->state().resource);
+			auto* typed = static_cast<BaseTemplate<T>*>(child);
+			typed->~BaseTemplate<T>();
+			allocator.deallocate(typed, 1);
+		}
+
+		template<class T>
+		static void save_child(const scope& node, unsigned char* out) {
+			detail::payload<BaseTemplate<T>>::write(static_cast<const BaseTemplate<T>&>(node), out);
+		}
+
+		/* Settings are assigned rather than copy constructed, so the clone never links back into source's tree */
+		template<class T>
+		static node_ptr clone_child(scope& parent, const scope& source) {
+			node_ptr owner = parent.make_child<T>();
+			{
+				detail::construction_scope construction(parent.state().resource);
+				static_cast<BaseTemplate<T>&>(*owner) = static_cast<const BaseTemplate<T>&>(source);
+			}
+			owner->active_member = source.active_member;
+			owner->clone_children(source);
+			return owner;
+		}
+
+		/* Deep copy every child of source, with its subtree, into this scope */
+		void clone_children(const scope& source) {
+			for (const auto& pair : source.view().children) {
+				own_tables().children.emplace(pair.first, pair.second.get_deleter().ops->clone(*this, *pair.second));
+			}
+			for (const auto& pair : source.view().member_children) {
+				own_tables().member_children.emplace(pair.first, pair.second.get_deleter().ops->clone(*this, *pair.second));
+				mark_member(static_member_key{ pair.first, member_key_hash{}(pair.first), layout_of(pair.first) });
+			}
+		}
+
+		/* Link a newly created child into this tree */
+		void adopt(scope& child) {
+			child.parent = this;
+			child.tree.store(&state(), std::memory_order_release);
+			invalidate_cache();
+		}
+
+		/* Called whenever scopes are added or reset, so every cached resolution is recomputed */
+		void invalidate_cache() {
+			++state().generation;
+		}
+
+		static std::uint32_t member_slot(const member_id& key) {
+			static std::mutex mutex;
+			static std::unordered_map<member_id, std::uint32_t, member_key_hash> slots;
+			std::lock_guard<std::mutex> lock(mutex);
+			return slots.emplace(key, static_cast<std::uint32_t>(slots.size())).first->second;
+		}
+
+		bool is_root() const { return parent == nullptr; }
+		bool has_parent() const { return parent != nullptr; }
+
+		template<class T>
+		static type_id get_type_key() { return type_id::of<T>(); }
+
+		/* Downcast a stored child to the settings of T, nullptr if it holds another type */
+		template<class T>
+		static BaseTemplate<T>* downcast(scope* child) {
+			if (!SVH_TYPE_TAGS) {
+				return dynamic_cast<BaseTemplate<T>*>(child);
+			}
+
+			BaseTemplate<T>* found = child->type_tag == type_id::of<T>() ? static_cast<BaseTemplate<T>*>(child) : nullptr;
+			if (SVH_CHECKED_CAST && found != dynamic_cast<BaseTemplate<T>*>(child)) {
+				detail::raise("Type tag does not match the dynamic type");
+			}
+			return found;
+		}
+
+		template<auto member>
+		static member_id make_member_key() {
+			using traits = member_pointer_traits<decltype(member)>;
+			return member_id{ get_type_key<typename traits::class_type>(), get_type_key<typename traits::member_type>(), get_member_offset<member>() };
+		}
+
+		/* Dense id of a (struct type, member type) pair, indexing tree_state::member_layouts, with alignof the member type */
+		struct layout_key {
+			std::uint32_t slot;
+			std::uint32_t align;
+		};
+
+		/* Key of a member pointer with its hash and layout */
+		struct static_member_key {
+			member_id key;
+			std::size_t hash;
+			layout_key layout;
+		};
+
+		/* Layout of the struct and member type of key, align is only given by the typed overload that registers it first */
+		static layout_key layout_of(const member_id& key, std::uint32_t align = 1) {
+			static std::mutex mutex;
+			static std::unordered_map<std::uint64_t, layout_key> layouts;
+			std::lock_guard<std::mutex> lock(mutex);
+			const std::uint64_t pair = (static_cast<std::uint64_t>(key.struct_type.value) << 32) | key.member_type.value;
+			return layouts.emplace(pair, layout_key{ static_cast<std::uint32_t>(layouts.size()), align }).first->second;
+		}
+
+		template<class T, class M>
+		static layout_key layout_of() {
+			static const layout_key layout = layout_of(member_id{ get_type_key<T>(), get_type_key<M>() }, alignof(M));
+			return layout;
+		}
+
+		/* Built once per member pointer, type ids are interned at runtime so this cannot be constexpr */
+		template<auto member>
+		static const static_member_key& member_key() {
+			static const static_member_key cached = [] {
+				using traits = member_pointer_traits<decltype(member)>;
+				const member_id key = make_member_key<member>();
+				return static_member_key{ key, member_key_hash{}(key), layout_of<typename traits::class_type, typename traits::member_type>() };
+			}();
+			return cached;
+		}
+
+		/* emplace_child for member settings, also marks the member in the tree */
+		template<class T, class... Args>
+		BaseTemplate<T>& emplace_member(const static_member_key& member, Args&&... args) {
+			auto& child = emplace_child<T>(own_tables().member_children, member.key, std::forward<Args>(args)...);
+			mark_member(member);
+			return child;
+		}
+
+		/* Record that a scope of this tree holds settings for member, see find_slot */
+		void mark_member(const static_member_key& member) {
+			if (member.key.offset % member.layout.align != 0) {
+				return; /* Misaligned members of packed structs have no slot */
+			}
+			auto& layouts = state().member_layouts;
+			if (layouts.size() <= member.layout.slot) {
+				layouts.resize(member.layout.slot + 1);
+			}
+			auto& slots = layouts[member.layout.slot];
+			const std::size_t index = member.key.offset / member.layout.align;
+			if (slots.size() <= index) {
+				slots.resize(index + 1);
+			}
+			slots[index] = detail::member_slot{ member.hash, true };
+		}
+
+		/* Slot of key in the tree, not pushed when no scope of the tree ever held settings for it */
+		detail::member_slot find_slot(const member_id& key, const layout_key& layout) const {
+			if (key.offset % layout.align != 0) {
+				return detail::member_slot{ member_key_hash{}(key), true };
+			}
+			const auto& layouts = state().member_layouts;
+			const std::size_t index = key.offset / layout.align;
+			if (layout.slot < layouts.size() && index < layouts[layout.slot].size()) {
+				return layouts[layout.slot][index];
+			}
+			return detail::member_slot{};
+		}
+
+		template<class T>
+		BaseTemplate<T>& emplace_new() {
+			return emplace_child<T>(own_tables().children, get_type_key<T>());
+		}
+
+		/* Type erased lookup behind find, returns the scope stored for key in this scope or the nearest parent */
+		scope* find_node(const type_id& key, const member_id& child_member_id = {}) const {
+			const member_id* member = &child_member_id;
+			for (const scope* current = this; current; current = current->parent) {
+				if (member->is_valid()) {
+					/* Check member map */
+					if (scope* found = current->find_member_child(*member)) {
+						return found;
+					}
+				} else {
+					/* Check current map */
+					if (scope* found = current->find_child(key)) {
+						return found;
+					}
+				}
+
+				/* Continue in the parent, with the member this scope was pushed for */
+				member = &current->active_member;
+			}
+			return nullptr; // Not found
+		}
+
+		/* find_node for lookups outside of a member, memoized per scope */
+		scope* find_cached(const type_id& key) const {
+			/* Readers share the tree under SVH_THREAD_SAFE, so the cache would be written concurrently */
+			if (!SVH_RESOLVE_CACHE || SVH_THREAD_SAFE) {
+				return find_node(key);
+			}
+
+			detail::tree_state& shared = state();
+			if (!resolve_cache) {
+				resolve_cache = allocate_table<cache_table>();
+			}
+			cache_entry& entry = (*resolve_cache)[key];
+			if (entry.generation == shared.generation) {
+				++shared.stats.hits;
+				return entry.found;
+			}
+
+			++shared.stats.misses;
+			entry.found = find_node(key);
+			entry.generation = shared.generation;
+			return entry.found;
+		}
+
+		/* Count a type lookup from this scope with SVH_INSTRUMENT, found being the scope it resolved to */
+		void record_lookup(const type_id& key, const scope* found) const {
+			if (!SVH_INSTRUMENT) {
+				return;
+			}
+			std::size_t depth = 0;
+			if (found) {
+				for (const scope* current = this; current && current != found->parent; current = current->parent) {
+					++depth;
+				}
+			}
+			detail::record(state().instruments, trace_event{ trace_kind::lookup, key, this, depth, found != nullptr }, type_tag);
+		}
+
+		/* Count an auto-insert or push copy of key into this scope with SVH_INSTRUMENT */
+		void record(trace_kind kind, const type_id& key) const {
+			if (!SVH_INSTRUMENT) {
+				return;
+			}
+			detail::record(state().instruments, trace_event{ kind, key, this, 0, true }, type_tag);
+		}
+
+		/* Byte offset of member inside instance, invalid_offset when it lies outside */
+		static constexpr std::size_t invalid_offset = std::numeric_limits<std::size_t>::max();
+
+		template<class T, class M>
+		static std::size_t runtime_offset(const T& instance, const M& member) {
+			const char* instance_addr = reinterpret_cast<const char*>(&instance);
+			const char* member_addr = reinterpret_cast<const char*>(&member);
+
+			// Validate that member is within instance bounds
+			if (member_addr < instance_addr || member_addr >= instance_addr + sizeof(T)) {
+				return invalid_offset;
+			}
+			return static_cast<std::size_t>(member_addr - instance_addr);
+		}
+
+		/* Settings of the member of type M at offset inside T */
+		template<class T, class M>
+		result<BaseTemplate<M>> find_member_offset(std::size_t offset) const {
+			if (offset == invalid_offset) {
+				return result<BaseTemplate<M>>::failure(scope_error::out_of_bounds);
+			}
+			return resolve_member_offset<T, M>(offset);
+		}
+
+		/* Lookup behind find_member_runtime, the member maps are only probed when the tree holds settings for the member */
+		template<class T, class M>
+		result<BaseTemplate<M>> resolve_member_offset(std::size_t member_offset) const {
+			const type_id struct_type = get_type_key<T>();
+			const type_id member_type = get_type_key<M>();
+			const auto key = member_id{ struct_type, member_type, member_offset };
+			const detail::member_slot slot = find_slot(key, layout_of<T, M>());
+
+			for (const scope* current = this; current; current = current->parent) {
+				/* Check member map */
+				if (slot.pushed) {
+					if (scope* existing = current->find_member_child(key, slot.hash)) {
+						return typed<M>(existing);
+					}
+				}
+
+				/* Check in children of type T */
+				if (scope* class_child = current->find_child(struct_type)) {
+					auto* class_scope = downcast<T>(class_child);
+					if (!class_scope) {
+						return result<BaseTemplate<M>>::failure(scope_error::type_mismatch);
+					}
+					auto found = typed<M>(class_scope->find_cached(member_type)); /* Not try_get, which would count a lookup the caller never made */
+					if (found.error() != scope_error::not_found) {
+						return found;
+					}
+				}
+			}
+			return result<BaseTemplate<M>>::failure(scope_error::not_found);
+		}
+
+		/* find_node for every pending key in one walk up the parents */
+		template<std::size_t N>
+		void find_nodes(const std::array<type_id, N>& keys, std::array<scope*, N>& found, std::array<bool, N>& pending) const {
+			std::size_t remaining = static_cast<std::size_t>(std::count(pending.begin(), pending.end(), true));
+			member_id child_member_id;
+			for (const scope* current = this; current && remaining != 0; current = current->parent) {
+				if (child_member_id.is_valid()) {
+					/* Inside a member scope every key resolves to the member child, as in find_node */
+					if (scope* member_child = current->find_member_child(child_member_id)) {
+						for (std::size_t i = 0; i < N; ++i) {
+							if (pending[i]) {
+								found[i] = member_child;
+								pending[i] = false;
+							}
+						}
+						return;
+					}
+				} else if (current->tables) {
+					const auto& children = current->tables->children;
+					if (children.size() <= children.linear_limit) {
+						/* Few children, one pass over them matches every pending key */
+						for (const auto& child : children) {
+							for (std::size_t i = 0; i < N; ++i) {
+								if (pending[i] && keys[i] == child.first) {
+									found[i] = child.second.get();
+									pending[i] = false;
+									--remaining;
+								}
+							}
+						}
+					} else {
+						for (std::size_t i = 0; i < N; ++i) {
+							if (!pending[i]) {
+								continue;
+							}
+							auto it = children.find(keys[i]);
+							if (it != children.end()) {
+								found[i] = it->second.get();
+								pending[i] = false;
+								--remaining;
+							}
+						}
+					}
+				}
+				child_member_id = current->active_member;
+			}
+		}
+
+		/* find_cached for several keys, the ones missing from the cache are resolved together */
+		template<std::size_t N>
+		void find_cached_nodes(const std::array<type_id, N>& keys, std::array<scope*, N>& found) const {
+			std::array<bool, N> pending{};
+			pending.fill(true);
+
+			if (!SVH_RESOLVE_CACHE || SVH_THREAD_SAFE) {
+				find_nodes(keys, found, pending);
+				return;
+			}
+
+			detail::tree_state& shared = state();
+			if (!resolve_cache) {
+				resolve_cache = allocate_table<cache_table>();
+			}
+			bool missed = false;
+			for (std::size_t i = 0; i < N; ++i) {
+				auto entry = resolve_cache->find(keys[i]);
+				if (entry != resolve_cache->end() && entry->second.generation == shared.generation) {
+					++shared.stats.hits;
+					found[i] = entry->second.found;
+					pending[i] = false;
+				} else {
+					++shared.stats.misses;
+					missed = true;
+				}
+			}
+			if (!missed) {
+				return;
+			}
+
+			const std::array<bool, N> walked = pending;
+			find_nodes(keys, found, pending);
+			for (std::size_t i = 0; i < N; ++i) {
+				if (walked[i]) {
+					(*resolve_cache)[keys[i]] = cache_entry{ found[i], shared.generation };
+				}
+			}
+		}
+
+		/* found as settings of T, or why it is not */
+		template<class T>
+		static result<BaseTemplate<T>> typed(scope* found) {
+			if (!found) {
+				return result<BaseTemplate<T>>::failure(scope_error::not_found);
+			}
+			auto* settings = downcast<T>(found);
+			if (!settings) {
+				return result<BaseTemplate<T>>::failure(scope_error::type_mismatch);
+			}
+			return result<BaseTemplate<T>>::success(settings);
+		}
+
+		/* Pointer behind a lookup that may come up empty, raising when it failed for another reason */
+		template<class T>
+		static T* checked(const result<T>& found, const char* mismatch = "Existing child has unexpected type") {
+			if (found.error() == scope_error::type_mismatch) {
+				detail::raise(mismatch);
+			}
+			if (found.error() == scope_error::out_of_bounds) {
+				detail::raise(to_string(found.error()));
+			}
+			return found.get();
+		}
+
+		template<class... Ts, std::size_t... I>
+		static std::tuple<BaseTemplate<Ts>*...> typed_all(const std::array<scope*, sizeof...(Ts)>& found, std::index_sequence<I...>) {
+			return std::tuple<BaseTemplate<Ts>*...>{ checked(typed<Ts>(found[I]))... };
+		}
+
+		template<class T>
+		BaseTemplate<T>& found_or_get(BaseTemplate<T>* found) {
+			return found ? *found : _get<T>();
+		}
+
+		template<class T>
+		const BaseTemplate<T>& found_or_get(BaseTemplate<T>* found) const {
+			return found ? *found : _get<T>();
+		}
+
+		/* Type erased lookup behind find_member */
+		scope* find_member_node(const member_id& key) const {
+			return find_member_node(key, member_key_hash{}(key));
+		}
+
+		scope* find_member_node(const member_id& key, std::size_t hash) const {
+			for (const scope* current = this; current; current = current->parent) {
+				/* Check member map */
+				if (scope* found = current->find_member_child(key, hash)) {
+					return found;
+				}
+
+				/* Check in children of the struct type */
+				if (scope* class_child = current->find_child(key.struct_type)) {
+					scope* found = class_child->find_node(key.member_type, key);
+					if (found) {
+						return found;
+					}
+				}
+
+				/* Check in children of member type */
+				if (scope* found = current->find_child(key.member_type)) {
+					return found;
+				}
+			}
+			return nullptr;
+		}
+
+		/* Actual implementation to push */
+		template<class T>
+		BaseTemplate<T>& _push() {
+			return *checked(_try_push<T>());
+		}
+
+		template<class T>
+		result<BaseTemplate<T>> _try_push() {
+			const type_id key = get_type_key<T>();
+			detail::write_guard lock(state());
+
+			/* Reuse if present */
+			if (scope* existing = find_child(key)) {
+				return typed<T>(existing);
 			}
 
-			/* Check in children of type ClassType */
-			auto class_it = children.find(struct_type);
-			if (class_it != children.end()) {
-				auto* class_scope = dynamic_cast<BaseTemplate<ClassType>*>(class_it->second.get());
-				if (!class_scope) {
-					throw std::runtime_error("Existing child has unexpected type");
+			/* copy if found recursive, bypassing the cache since every push changes the tree anyway */
+			if (has_parent()) {
+				if (scope* found = find_node(key)) {
+					auto source = typed<T>(found);
+					if (!source) {
+						return source;
+					}
+					record(trace_kind::push_copy, key);
+					detail::linked_copy_scope link(&*source, sizeof(*source));
+					return result<BaseTemplate<T>>::success(&emplace_child<T>(own_tables().children, key, *source)); /* Copy, only the settings are carried over */
 				}
-				auto* found = class_scope->template find<MemberType>(key);
+			}
+
+			/* Else create new */
+			return result<BaseTemplate<T>>::success(&emplace_new<T>());
+		}
+
+
+		template<class T>
+		BaseTemplate<T>& _get() {
+
+			auto* found = find<T>();
+			if (found) {
+				return *found;
+			}
+
+			if (SVH_AUTO_INSERT) {
+				detail::write_guard lock(state());
+				found = checked(typed<T>(find_cached(get_type_key<T>()))); /* Another thread may have inserted it meanwhile, not counted as another lookup */
 				if (found) {
-					return found;
+					return *found;
 				}
+				record(trace_kind::auto_insert, get_type_key<T>());
+				return emplace_new<T>();
 			}
 
-			/* Check in children of member type */
-			auto member_it = children.find(member_type);
-			if (member_it != children.end()) {
-				auto* member_scope = dynamic_cast<BaseTemplate<MemberType>*>(member_it->second.get());
-				if (!member_scope) {
-					throw std::runtime_error("Existing child has unexpected type");
-				}
-				return member_scope;
+			detail::raise("Type not found");
+		}
+
+		template<class T>
+		const BaseTemplate<T>& _get() const {
+			auto* found = find<T>();
+			if (found) {
+				return *found;
 			}
+			detail::raise("Type not found");
+		}
+	};
 
-			/* Recurse to parent */
-			if (has_parent()) {
-				return parent->find_member<member>();
+	/// <summary>
+	/// Immutable, flattened snapshot of a scope tree. Created with ``scope::freeze()``.
+	/// Rows are the scopes of the tree, columns are the types and members stored anywhere in it,
+	/// and every cell holds the row that a lookup from that scope resolves to, parents included.
+	/// </summary>
+	template<template<class> class BaseTemplate>
+	struct frozen_scope {
+	private:
+		using scope_type = scope<BaseTemplate>;
+		using member_id = typename scope_type::member_id;
+
+		/* Cell value when the resolved scope does not hold the requested type */
+		static constexpr std::uint32_t mismatch = detail::npos - 1;
+	public:
+
+		/// <summary>
+		/// Handle to a single scope inside the snapshot.
+		/// </summary>
+		struct node {
+			/// <summary>
+			/// Find the settings for type T as seen from this scope.
+			/// </summary>
+			/// <typeparam name="T">The type of the settings to find</typeparam>
+			/// <returns>Pointer to the settings or nullptr if not found</returns>
+			/// <exception cref="std::runtime_error">If the resolved scope has an unexpected type</exception>
+			template<class T>
+			const BaseTemplate<simplify_t<T>>* find() const {
+				const std::uint32_t row = owner->resolve_type(index, type_id::of<simplify_t<T>>());
+				return row == detail::npos ? nullptr : &owner->template settings_at<simplify_t<T>>(row);
+			}
+
+			/// <summary>
+			/// Get the settings for type T as seen from this scope.
+			/// </summary>
+			/// <typeparam name="T">The type of the settings to get</typeparam>
+			/// <returns>Reference to the settings</returns>
+			/// <exception cref="std::runtime_error">If not found</exception>
+			template<class T>
+			const BaseTemplate<simplify_t<T>>& get() const {
+				return owner->template settings_at<simplify_t<T>>(at<T>().index);
+			}
+
+			template<template<class...> class T>
+			const BaseTemplate<simplify_template_t<T>>& get() const {
+				return owner->template settings_at<simplify_template_t<T>>(at<T>().index);
+			}
+
+			template<class T, class U, class... Rest>
+			const auto& get() const {
+				return at<T>().template get<U, Rest...>();
+			}
+
+			/// <summary>
+			/// Move to the scope that holds the settings for type T, to continue looking up from there.
+			/// </summary>
+			/// <typeparam name="T">The type of the scope</typeparam>
+			/// <returns>Handle to the resolved scope</returns>
+			/// <exception cref="std::runtime_error">If not found</exception>
+			template<class T>
+			node at() const {
+				return owner->checked(owner->resolve_type(index, type_id::of<simplify_t<T>>()));
+			}
+
+			template<template<class...> class T>
+			node at() const {
+				return owner->checked(owner->resolve_type(index, type_id::of<simplify_template_t<T>>()));
+			}
+
+			template<class T, class U, class... Rest>
+			node at() const {
+				return at<T>().template at<U, Rest...>();
+			}
+
+			/// <summary>
+			/// Get member settings as seen from this scope.
+			/// </summary>
+			/// <typeparam name="member">Auto-deduced member pointer</typeparam>
+			/// <returns>Reference to member settings</returns>
+			/// <exception cref="std::runtime_error">If not found</exception>
+			template<auto member>
+			const auto& get_member() const {
+				using MemberType = typename member_pointer_traits<decltype(member)>::member_type;
+				return owner->template settings_at<MemberType>(at_member<member>().index);
+			}
+
+			/// <summary>
+			/// Move to the scope that holds the settings for a member.
+			/// </summary>
+			/// <typeparam name="member">Auto-deduced member pointer</typeparam>
+			/// <returns>Handle to the resolved scope</returns>
+			/// <exception cref="std::runtime_error">If not found</exception>
+			template<auto member>
+			node at_member() const {
+				using MemberType = typename member_pointer_traits<decltype(member)>::member_type;
+				static const member_id& key = scope_type::template member_key<member>().key;
+				static const std::uint32_t slot = scope_type::member_slot(key);
+				return owner->checked(owner->resolve_member(index, slot, key, type_id::of<MemberType>()));
+			}
+
+			/// <summary>
+			/// The live scope this handle refers to.
+			/// </summary>
+			const scope_type& source() const {
+				return *owner->nodes[index];
 			}
 
-			return static_cast<BaseTemplate<MemberType>*>(nullptr);
+		private:
+			friend struct frozen_scope;
+
+			node(const frozen_scope* owner, std::uint32_t index) : owner(owner), index(index) {}
+
+			const frozen_scope* owner;
+			std::uint32_t index;
+		};
+
+		/// <summary>
+		/// Handle to the scope ``freeze()`` was called on.
+		/// </summary>
+		node root() const {
+			return node(this, origin);
+		}
+
+		template<class T>
+		const auto* find() const {
+			return root().template find<T>();
+		}
+
+		template<class... T>
+		const auto& get() const {
+			return root().template get<T...>();
+		}
+
+		template<template<class...> class T>
+		const auto& get() const {
+			return root().template get<T>();
+		}
+
+		template<class... T>
+		node at() const {
+			return root().template at<T...>();
+		}
+
+		template<auto member>
+		const auto& get_member() const {
+			return root().template get_member<member>();
 		}
 
 		/// <summary>
-		/// Find member settings using runtime instance and member reference.
+		/// Number of scopes in the snapshot.
 		/// </summary>
-		/// <typeparam name="T">Parent class type</typeparam>
-		/// <typeparam name="M">Member type</typeparam>
-		/// <param name="instance">Instance containing the member</param>
-		/// <param name="member">Reference to the specific member</param>
-		/// <returns>Pointer to member settings or nullptr if not found</returns>
-		template<class T, class M>
-		BaseTemplate<M>* find_member_runtime(const T& instance, const M& member) const {
-			// Calculate offset using pointer arithmetic
-			const char* instance_addr = reinterpret_cast<const char*>(&instance);
-			const char* member_addr = reinterpret_cast<const char*>(&member);
+		std::size_t size() const {
+			return nodes.size();
+		}
 
-			// Validate that member is within instance bounds
-			if (member_addr < instance_addr || member_addr >= instance_addr + sizeof(T)) {
-				throw std::runtime_error("Member is not within instance bounds");
+	private:
+		friend struct scope<BaseTemplate>;
+		friend struct detail::binary_format<BaseTemplate>;
+		using node_ops = typename scope_type::node_ops;
+
+		explicit frozen_scope(const scope_type& source) {
+			/* The whole tree is captured, so lookups that fall back to parents stay inside the snapshot */
+			const scope_type* top = &source;
+			while (top->has_parent()) {
+				top = top->parent;
 			}
 
-			const std::size_t member_offset = static_cast<std::size_t>(member_addr - instance_addr);
-			const std::type_index struct_type = get_type_key<T>();
-			const std::type_index member_type = get_type_key<M>();
-			const auto key = member_id{ struct_type, member_type, member_offset };
+			std::unordered_map<member_id, std::uint32_t, typename scope_type::member_key_hash> member_keys;
+			std::vector<std::uint32_t> type_rows; /* rows stored as type children */
 
-			/* Check member map */
-			auto it = member_children.find(key);
-			if (it != member_children.end()) {
-				auto* found = dynamic_cast<BaseTemplate<M>*>(it->second.get());
-				if (!found) {
-					throw std::runtime_error("Existing member child has unexpected type");
+			add_row(top, type_id{}, nullptr);
+			for (std::size_t i = 0; i < nodes.size(); ++i) {
+				const scope_type* current = nodes[i];
+				for (const auto& pair : current->view().children) {
+					/* Type ids are dense, so they index the column map directly */
+					if (pair.first.value >= type_columns.size()) {
+						type_columns.resize(pair.first.value + 1, detail::npos);
+					}
+					if (type_columns[pair.first.value] == detail::npos) {
+						type_columns[pair.first.value] = static_cast<std::uint32_t>(type_column_keys.size());
+						type_column_keys.push_back(pair.first);
+					}
+					type_rows.push_back(static_cast<std::uint32_t>(nodes.size()));
+					add_row(pair.second.get(), pair.first, pair.second.get_deleter().ops);
 				}
-				return found;
+				for (const auto& pair : current->view().member_children) {
+					if (member_keys.emplace(pair.first, static_cast<std::uint32_t>(member_column_keys.size())).second) {
+						member_column_keys.push_back(pair.first);
+					}
+					add_row(pair.second.get(), pair.first.member_type, pair.second.get_deleter().ops);
+				}
+			}
+			origin = rows.at(&source);
+
+			/* Map dense member slots to columns */
+			const std::uint32_t member_offset = static_cast<std::uint32_t>(type_column_keys.size());
+			for (std::uint32_t column = 0; column < member_column_keys.size(); ++column) {
+				const std::uint32_t slot = scope_type::member_slot(member_column_keys[column]);
+				if (slot >= member_columns.size()) {
+					member_columns.resize(slot + 1, detail::npos);
+				}
+				member_columns[slot] = member_offset + column;
 			}
 
-			/* Check in children of type T */
-			auto class_it = children.find(struct_type);
-			if (class_it != children.end()) {
-				auto* class_scope = dynamic_cast<BaseTemplate<T>*>(class_it->second.get());
-				if (!class_scope) {
-					throw std::runtime_error("Existing child has unexpected type");
+			/* Resolve every cell once, using the same lookups as the live tree */
+			width = type_column_keys.size() + member_column_keys.size();
+			table.resize(nodes.size() * width, detail::npos);
+			for (std::size_t row = 0; row < nodes.size(); ++row) {
+				std::uint32_t* cells = table.data() + row * width;
+				for (std::uint32_t column = 0; column < type_column_keys.size(); ++column) {
+					cells[column] = cell(nodes[row]->find_node(type_column_keys[column]), type_column_keys[column]);
 				}
-				auto* found = class_scope->template find<M>();
-				if (found) {
-					return found;
+				for (std::uint32_t column = 0; column < member_column_keys.size(); ++column) {
+					const member_id& key = member_column_keys[column];
+					cells[member_offset + column] = cell(nodes[row]->find_member_node(key), key.member_type);
 				}
 			}
 
-			/* Recurse to parent */
-			if (has_parent()) {
-				return parent->find_member_runtime(instance, member);
+			/* Append the fallback columns */
+			const std::vector<std::vector<std::uint32_t>> fallback_cells = resolve_fallbacks(type_rows);
+			if (!fallback_cells.empty()) {
+				const std::size_t stored = width;
+				std::vector<std::uint32_t> wide(nodes.size() * (stored + fallback_cells.size()));
+				for (std::size_t row = 0; row < nodes.size(); ++row) {
+					std::uint32_t* cells = wide.data() + row * (stored + fallback_cells.size());
+					std::copy_n(table.data() + row * stored, stored, cells);
+					for (std::size_t column = 0; column < fallback_cells.size(); ++column) {
+						cells[stored + column] = fallback_cells[column][row];
+					}
+				}
+				table = std::move(wide);
+				width = stored + fallback_cells.size();
 			}
-
-			return nullptr;
 		}
 
-		/// <summary>
-		/// Get member settings using runtime instance and member reference.
-		/// </summary>
-		/// <typeparam name="T">Parent class type</typeparam>
-		/// <typeparam name="M">Member type</typeparam>
-		/// <param name="instance">Instance containing the member</param>
-		/// <param name="member">Reference to the specific member</param>
-		/// <returns>Reference to member settings</returns>
-		template<class T, class M>
-		BaseTemplate<M>& get_member(const T& instance, const M& member) {
-			auto* found = find_member_runtime(instance, member);
-			if (found) {
-				return *found;
+		/*
+		Columns for members that are not stored in the tree. Such a member resolves the same for every offset,
+		to settings of its member type found from the scope or from its struct scopes, so one column per (struct type, member type) covers it.
+		Only columns that differ from the type column of the member type are kept, which happens inside member scopes
+		since find_member_node does not stop at them like find_node. An invalid type stands for none, or for member types without a column.
+		*/
+		std::vector<std::vector<std::uint32_t>> resolve_fallbacks(const std::vector<std::uint32_t>& type_rows) {
+			std::vector<std::vector<std::uint32_t>> columns;
+			const auto sort_fallbacks = [&] {
+				std::sort(fallbacks.begin(), fallbacks.end(), [](const fallback_key& a, const fallback_key& b) { return a.before(b.struct_type, b.member_type); });
+			};
+			const auto add = [&](type_id struct_type, type_id member_type, std::vector<std::uint32_t> cells) {
+				fallbacks.push_back(fallback_key{ struct_type, member_type, static_cast<std::uint32_t>(width + columns.size()) });
+				columns.push_back(std::move(cells));
+			};
+
+			const auto resolve = [&](type_id struct_type, type_id member_type) {
+				/* An offset no member has, so the key never matches stored members */
+				const member_id key{ struct_type, member_type, std::numeric_limits<std::size_t>::max() - 1 };
+				std::vector<std::uint32_t> cells(nodes.size());
+				for (std::size_t row = 0; row < nodes.size(); ++row) {
+					const scope_type* found = nodes[row]->find_member_node(key);
+					cells[row] = found ? rows.at(found) : detail::npos;
+				}
+				return cells;
+			};
+			const auto differs = [&](const std::vector<std::uint32_t>& cells, type_id member_type, std::uint32_t column) {
+				for (std::uint32_t row = 0; row < nodes.size(); ++row) {
+					std::uint32_t expected = detail::npos;
+					if (column != detail::npos) {
+						expected = column < width ? table[row * width + column] : columns[column - width][row];
+					}
+					if (checked_cell(cells[row], member_type) != checked_cell(expected, member_type)) {
+						return true;
+					}
+				}
+				return false;
+			};
+
+			/* Inside member scopes a member type can resolve differently from its type column even without struct scopes */
+			for (std::uint32_t column = 0; column < type_column_keys.size(); ++column) {
+				std::vector<std::uint32_t> cells = resolve(type_id{}, type_column_keys[column]);
+				if (differs(cells, type_column_keys[column], column)) {
+					add(type_id{}, type_column_keys[column], std::move(cells));
+				}
+			}
+			sort_fallbacks(); /* base_column searches them */
+
+			std::vector<std::pair<type_id, type_id>> candidates;
+			for (std::uint32_t row : type_rows) {
+				const scope_type* struct_scope = nodes[row];
+				bool in_member = false;
+				for (const scope_type* current = struct_scope->parent; current && !in_member; current = current->parent) {
+					in_member = current->active_member.is_valid();
+				}
+				if (in_member) {
+					/* Lookups through this scope can end at the member scope, whatever the member type */
+					for (type_id member_type : type_column_keys) {
+						candidates.emplace_back(row_types[row], member_type);
+					}
+					candidates.emplace_back(row_types[row], type_id{});
+				}
+			}
+			std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+				return std::make_pair(a.first.value, a.second.value) < std::make_pair(b.first.value, b.second.value);
+			});
+			candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+			for (const auto& [struct_type, member_type] : candidates) {
+				std::vector<std::uint32_t> cells = resolve(struct_type, member_type);
+				if (differs(cells, member_type, base_column(member_type))) {
+					add(struct_type, member_type, std::move(cells));
+				}
 			}
 
-			if (SVH_AUTO_INSERT) {
-				// Create new member settings at runtime
-				const char* instance_addr = reinterpret_cast<const char*>(&instance);
-				const char* member_addr = reinterpret_cast<const char*>(&member);
-				const std::size_t member_offset = static_cast<std::size_t>(member_addr - instance_addr);
-				const std::type_index struct_type = get_type_key<T>();
-				const std::type_index member_type = get_type_key<M>();
-				const auto key = member_id{ struct_type, member_type, member_offset };
+			sort_fallbacks();
+			return columns;
+		}
+
+		void add_row(const scope_type* s, type_id type, const node_ops* ops) {
+			rows.emplace(s, static_cast<std::uint32_t>(nodes.size()));
+			nodes.push_back(s);
+			row_types.push_back(type);
+			row_ops.push_back(ops);
+		}
 
-				auto child = std::make_unique<BaseTemplate<M>>();
-				auto& ref = *child;
-				child->parent = this;
-				member_children.emplace(key, std::move(child));
-				return ref;
+		std::uint32_t cell(const scope_type* found, type_id type) const {
+			if (!found) {
+				return detail::npos;
 			}
+			const std::uint32_t row = rows.at(found);
+			return row_types[row] == type ? row : mismatch;
+		}
 
-			throw std::runtime_error("Member settings not found");
+		std::uint32_t resolve_type(std::uint32_t row, type_id type) const {
+			if (type.value >= type_columns.size() || type_columns[type.value] == detail::npos) {
+				return detail::npos;
+			}
+			return table[row * width + type_columns[type.value]];
 		}
 
-		/// <summary>
-		/// Get member settings using runtime instance and member reference (const version).
-		/// </summary>
-		/// <typeparam name="T">Parent class type</typeparam>
-		/// <typeparam name="M">Member type</typeparam>
-		/// <param name="instance">Instance containing the member</param>
-		/// <param name="member">Reference to the specific member</param>
-		/// <returns>Const reference to member settings</returns>
-		template<class T, class M>
-		const BaseTemplate<M>& get_member(const T& instance, const M& member) const {
-			auto* found = find_member_runtime(instance, member);
-			if (found) {
-				return *found;
+		std::uint32_t resolve_member(std::uint32_t row, std::uint32_t slot, const member_id& key, type_id type) const {
+			if (slot < member_columns.size() && member_columns[slot] != detail::npos) {
+				return table[row * width + member_columns[slot]];
 			}
+			/* Member is not stored in the tree, it can still resolve through the struct scopes or to settings of the member type */
+			const bool has_column = type.value < type_columns.size() && type_columns[type.value] != detail::npos;
+			const type_id member_type = has_column ? type : type_id{};
+			std::uint32_t column = find_fallback(key.struct_type, member_type);
+			if (column == detail::npos) {
+				column = base_column(member_type);
+			}
+			return column == detail::npos ? detail::npos : checked_cell(table[row * width + column], type);
+		}
 
-			throw std::runtime_error("Member settings not found");
+		/* Column for a member of member_type that is not stored and not reached through struct scopes, npos if it never resolves */
+		std::uint32_t base_column(type_id member_type) const {
+			const std::uint32_t column = find_fallback(type_id{}, member_type);
+			if (column != detail::npos || !member_type.is_valid()) {
+				return column;
+			}
+			return type_columns[member_type.value];
 		}
 
-		/// <summary>
-		/// Debug log the scope tree to console.
-		/// </summary>
-		/// <param name="indent">Indentation level</param>
-		void debug_log(int indent = 0) const {
-			std::string prefix(indent, '==');
-			for (const auto& pair : children) {
-				const auto& key = pair.first;
-				const auto& child = pair.second;
-				const auto& name = key.name();
-				std::cout << prefix << name << "\n";
-				child->debug_log(indent + 2);
-			}
-			for (const auto& item : member_children) {
-				const auto& key = item.first;
-				const auto& child = item.second;
-				const auto& struct_name = key.struct_type.name();
-				const auto& member_name = key.member_type.name();
-				std::cout << prefix << struct_name << "::(offset " << key.offset << ") -> " << member_name << "\n";
-				child->debug_log(indent + 2);
+		std::uint32_t find_fallback(type_id struct_type, type_id member_type) const {
+			auto it = std::lower_bound(fallbacks.begin(), fallbacks.end(), fallback_key{ struct_type, member_type, 0 },
+				[](const fallback_key& a, const fallback_key& b) { return a.before(b.struct_type, b.member_type); });
+			return it != fallbacks.end() && it->struct_type == struct_type && it->member_type == member_type ? it->column : detail::npos;
+		}
+
+		/* Fallback cells hold the resolved row whatever its type, so the type is checked on lookup */
+		std::uint32_t checked_cell(std::uint32_t found, type_id type) const {
+			if (found == detail::npos || found == mismatch) {
+				return found;
 			}
+			return row_types[found] == type ? found : mismatch;
 		}
-	private:
-		struct member_id {
-			std::type_index struct_type = typeid(void);
-			std::type_index member_type = typeid(void);
-			std::size_t offset = std::numeric_limits<std::size_t>::max();
 
-			bool is_valid() const {
-				return struct_type != typeid(void) && member_type != typeid(void) && offset != std::numeric_limits<std::size_t>::max();
+		node checked(std::uint32_t row) const {
+			if (row == detail::npos) {
+				detail::raise("Type not found");
+			}
+			if (row == mismatch) {
+				detail::raise("Existing child has unexpected type");
 			}
+			return node(this, row);
+		}
 
-			bool operator==(const member_id& other) const {
-				return struct_type == other.struct_type && member_type == other.member_type && offset == other.offset;
+		template<class T>
+		const BaseTemplate<T>& settings_at(std::uint32_t row) const {
+			if (row == mismatch) {
+				detail::raise("Existing child has unexpected type");
 			}
-		};
-		struct member_key_hash {
-			std::size_t operator()(const member_id& k) const {
-				return std::hash<std::type_index>()(k.struct_type) ^ std::hash<std::type_index>()(k.member_type) ^ std::hash<std::size_t>()(k.offset);
+			return *static_cast<const BaseTemplate<T>*>(nodes[row]);
+		}
+
+		std::vector<const scope_type*> nodes;
+		std::unordered_map<const scope_type*, std::uint32_t> rows;
+		std::vector<type_id> row_types;            /* type each row holds */
+		std::vector<const node_ops*> row_ops;      /* operations on the settings of each row, nullptr for the root */
+		std::vector<type_id> type_column_keys;     /* column -> type */
+		std::vector<member_id> member_column_keys; /* column - type columns -> member */
+		std::vector<std::uint32_t> type_columns;   /* type id -> column */
+		std::vector<std::uint32_t> member_columns; /* dense member slot -> column */
+		struct fallback_key {
+			type_id struct_type;  /* invalid when no struct scope is involved */
+			type_id member_type;  /* invalid for member types without a type column */
+			std::uint32_t column;
+
+			bool before(type_id other_struct, type_id other_member) const {
+				return struct_type.value != other_struct.value ? struct_type.value < other_struct.value : member_type.value < other_member.value;
 			}
 		};
-	protected:
-		scope* parent = nullptr; /* Root level */
+		std::vector<fallback_key> fallbacks;       /* sorted by types, columns of members that are not stored */
+		std::vector<std::uint32_t> table;          /* row * width + column -> resolved row */
+		std::size_t width = 0;
+		std::uint32_t origin = 0;
+	};
 
-		/* type -> scope */
-		std::unordered_map<std::type_index, std::shared_ptr<scope>> children; /* shared since we need to copy the base*/
-		/* (struct type + member type + offset) -> scope */
-		std::unordered_map<member_id, std::shared_ptr<scope>, member_key_hash> member_children;
+	/// <summary>
+	/// Handle to a scope tree that is reconfigured while other threads read it.
+	/// Every version is an immutable tree with its frozen snapshot. Writers build the next version as a deep copy
+	/// through the fluent push/pop API and publish it atomically; readers load the current version once and never block.
+	/// Replaced versions are reclaimed once no reader holds them, tracked with one hazard pointer per active reader.
+	/// </summary>
+	template<template<class> class BaseTemplate>
+	class versioned_scope {
+		using scope_type = scope<BaseTemplate>;
 
-		member_id active_member;
+		struct version {
+			explicit version(std::pmr::memory_resource* resource, std::uint64_t number) : root(resource), number(number) {}
 
-		bool is_root() const { return parent == nullptr; }
-		bool has_parent() const { return parent != nullptr; }
+			scope_type root;
+			std::optional<frozen_scope<BaseTemplate>> frozen; /* Set once the version is complete */
+			std::uint64_t number;
+		};
 
-		template<class T>
-		constexpr std::type_index get_type_key() const { return std::type_index{ typeid(std::decay_t<T>) }; }
+		/* Hazard pointer of one reader. Records are reused, never freed before the handle */
+		struct hazard_record {
+			std::atomic<const version*> pointer{ nullptr };
+			std::atomic<bool> active{ false };
+			hazard_record* next = nullptr;
+		};
+	public:
 
-		template<class T>
-		BaseTemplate<T>& emplace_new() {
-			const std::type_index key = get_type_key<T>();
-			auto child = std::make_unique<BaseTemplate<T>>();
-			auto& ref = *child;
-			child->parent = this;
-			child->children.clear(); /* Clear children, we only create the base settings */
-			child->member_children.clear(); /* Clear member children, we only create the base settings */
-			children.emplace(key, std::move(child));
-			return ref;
+		/// <summary>
+		/// Version held by a reader. The snapshot stays valid and unchanged until the handle is destroyed,
+		/// however many versions are published meanwhile.
+		/// </summary>
+		class snapshot {
+		public:
+			snapshot(snapshot&& other) noexcept : record(other.record), held(other.held) {
+				other.record = nullptr;
+				other.held = nullptr;
+			}
+			snapshot& operator=(snapshot&& other) noexcept {
+				std::swap(record, other.record);
+				std::swap(held, other.held);
+				return *this;
+			}
+			snapshot(const snapshot&) = delete;
+			snapshot& operator=(const snapshot&) = delete;
+
+			~snapshot() {
+				if (record) {
+					record->pointer.store(nullptr, std::memory_order_release);
+					record->active.store(false, std::memory_order_release);
+				}
+			}
+
+			const frozen_scope<BaseTemplate>& operator*() const { return *held->frozen; }
+			const frozen_scope<BaseTemplate>* operator->() const { return &*held->frozen; }
+
+			/* Number of the held version, starting at 1 and increasing with every publication */
+			std::uint64_t number() const { return held->number; }
+
+		private:
+			friend class versioned_scope;
+			snapshot(hazard_record* record, const version* held) : record(record), held(held) {}
+
+			hazard_record* record;
+			const version* held;
+		};
+
+		/// <summary>
+		/// Create a handle whose first version is an empty tree.
+		/// </summary>
+		/// <param name="resource">Memory resource backing every version, must outlive the handle</param>
+		explicit versioned_scope(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : resource(resource) {
+			current.store(complete(new version(resource, 1)), std::memory_order_release);
 		}
 
-		/* Actual implementation to push */
-		template<class T>
-		BaseTemplate<T>& _push() {
-			const std::type_index key = get_type_key<T>();
+		versioned_scope(const versioned_scope&) = delete;
+		versioned_scope& operator=(const versioned_scope&) = delete;
 
-			/* Reuse if present */
-			auto it = children.find(key);
-			if (it != children.end()) {
-				auto* found = dynamic_cast<BaseTemplate<T>*>(it->second.get());
-				if (!found) {
-					throw std::runtime_error("Existing child has unexpected type");
-				}
-				return *found;
+		/* Readers must have released their snapshots */
+		~versioned_scope() {
+			delete current.load(std::memory_order_acquire);
+			for (const version* old : retired) {
+				delete old;
+			}
+			hazard_record* record = hazards.load(std::memory_order_acquire);
+			while (record) {
+				hazard_record* next = record->next;
+				delete record;
+				record = next;
 			}
+		}
 
-			/* copy if found recursive */
-			if (has_parent()) {
-				auto* found = find<T>();
-				if (found) {
-					auto child = std::make_unique<BaseTemplate<T>>(*found); /* Copy */
-					auto& ref = *child;
-					child->parent = this;
-					child->children.clear(); /* Clear children, we only copy the base settings */
-					child->member_children.clear(); /* Clear member children, we only copy the base settings */
-					children.emplace(key, std::move(child));
-					return ref;
+		/// <summary>
+		/// Pin the current version for reading. Wait-free apart from retrying while a publication races the load.
+		/// </summary>
+		/// <returns>Snapshot of the current version</returns>
+		snapshot read() const {
+			hazard_record* record = acquire_record();
+			const version* held = current.load(std::memory_order_acquire);
+			for (;;) {
+				record->pointer.store(held, std::memory_order_seq_cst);
+				const version* again = current.load(std::memory_order_seq_cst);
+				if (again == held) {
+					return snapshot(record, held);
 				}
+				held = again;
 			}
+		}
 
-			/* Else create new */
-			return emplace_new<T>();
+		/// <summary>
+		/// Publish a new version: a deep copy of the current tree, changed by edit through the usual push/pop API.
+		/// Writers are serialized; readers keep the version they hold until they release it.
+		/// </summary>
+		/// <param name="edit">Called with the root of the new version, e.g. ``[](auto& root) { root.push<int>().max(5).pop(); }``</param>
+		/// <returns>Number of the published version</returns>
+		template<class Edit>
+		std::uint64_t update(Edit&& edit) {
+			std::lock_guard<std::mutex> lock(writer);
+			const version* previous = current.load(std::memory_order_relaxed);
+
+			std::unique_ptr<version> next(new version(resource, previous->number + 1));
+			next->root.clone_children(previous->root);
+			edit(next->root);
+			complete(next.get());
+
+			const std::uint64_t number = next->number;
+			current.store(next.release(), std::memory_order_seq_cst);
+			retired.push_back(previous);
+			reclaim_retired();
+			return number;
 		}
 
+		/* Replaced versions still held by readers */
+		std::size_t retired_count() const {
+			std::lock_guard<std::mutex> lock(writer);
+			return retired.size();
+		}
 
-		template<class T>
-		BaseTemplate<T>& _get() {
+		/// <summary>
+		/// Free replaced versions no reader holds anymore. Also done after every update.
+		/// </summary>
+		void reclaim() {
+			std::lock_guard<std::mutex> lock(writer);
+			reclaim_retired();
+		}
 
-			auto* found = find<T>();
-			if (found) {
-				return *found;
-			}
+	private:
+		static version* complete(version* built) {
+			built->frozen.emplace(built->root.freeze());
+			return built;
+		}
 
-			if (SVH_AUTO_INSERT) {
-				return emplace_new<T>();
+		/* Free retired versions without a hazard pointer on them, with writer held */
+		void reclaim_retired() {
+			std::vector<const version*> in_use;
+			for (hazard_record* record = hazards.load(std::memory_order_acquire); record; record = record->next) {
+				if (const version* held = record->pointer.load(std::memory_order_seq_cst)) {
+					in_use.push_back(held);
+				}
 			}
 
-			throw std::runtime_error("Type not found");
+			auto kept = retired.begin();
+			for (const version* old : retired) {
+				if (std::find(in_use.begin(), in_use.end(), old) != in_use.end()) {
+					*kept++ = old;
+				} else {
+					delete old;
+				}
+			}
+			retired.erase(kept, retired.end());
 		}
 
-		template<class T>
-		const BaseTemplate<T>& _get() const {
-			auto* found = find<T>();
-			if (found) {
-				return *found;
+		/* Claim a free hazard record, or add one */
+		hazard_record* acquire_record() const {
+			for (hazard_record* record = hazards.load(std::memory_order_acquire); record; record = record->next) {
+				bool expected = false;
+				if (!record->active.load(std::memory_order_relaxed) && record->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+					return record;
+				}
 			}
-			throw std::runtime_error("Type not found");
+
+			hazard_record* record = new hazard_record();
+			record->active.store(true, std::memory_order_relaxed);
+			hazard_record* head = hazards.load(std::memory_order_relaxed);
+			do {
+				record->next = head;
+			} while (!hazards.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+			return record;
 		}
+
+		std::pmr::memory_resource* resource;
+		std::atomic<const version*> current{ nullptr };
+		mutable std::atomic<hazard_record*> hazards{ nullptr };
+		mutable std::mutex writer;
+		std::vector<const version*> retired; /* Replaced versions, guarded by writer */
 	};
 } // namespace svh
 
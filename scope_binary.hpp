@@ -0,0 +1,760 @@
+#pragma once
+#include "scope.hpp"
+
+#include <fstream>
+#include <ostream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+Binary files of scope trees, written with ``save_binary`` and used in place with ``mapped_tree``.
+A file holds the frozen snapshot of a tree: one row per scope with its parent and the packed ``reflect`` fields of its settings,
+and the resolution table of ``frozen_scope`` with its fallback columns for members that were never pushed,
+so lookups in a mapped file are a search for the column and one read of the table.
+Types are identified by ``type_hash``, so files are read by builds from the same compiler family with the same settings layouts.
+*/
+namespace svh {
+	namespace detail {
+		namespace binary {
+			constexpr char magic[4] = { 'S', 'V', 'H', 'T' };
+			constexpr std::uint32_t version = 3; /* 2: types keyed by type_hash instead of a hash of typeid names, 3: fallback columns */
+			constexpr std::uint32_t byte_order = 0x01020304; /* Reads back differently on a machine with the other endianness */
+			constexpr std::size_t section_align = 8;
+
+			struct header {
+				char magic[4];
+				std::uint32_t version;
+				std::uint32_t byte_order;
+				std::uint32_t origin;       /* row the tree was saved from */
+				std::uint32_t rows;
+				std::uint32_t types;
+				std::uint32_t members;
+				std::uint32_t type_columns; /* the table has type_columns + members + fallbacks columns */
+				std::uint32_t payload_align;
+				std::uint32_t fallbacks;
+				std::uint64_t types_offset;
+				std::uint64_t members_offset;
+				std::uint64_t fallbacks_offset;
+				std::uint64_t rows_offset;
+				std::uint64_t table_offset;
+				std::uint64_t names_offset;
+				std::uint64_t payloads_offset;
+				std::uint64_t size;
+			};
+
+			/* Sorted by name_hash */
+			struct type_record {
+				std::uint64_t name_hash;
+				std::uint64_t signature;    /* of the payload layout, see ``payload::signature`` */
+				std::uint32_t name_offset;  /* into the names section, without terminator */
+				std::uint32_t name_size;
+				std::uint32_t column;       /* npos if the type is never stored as a type child */
+				std::uint32_t payload_size;
+			};
+
+			/* Sorted by key_hash */
+			struct member_record {
+				std::uint64_t key_hash;
+				std::uint64_t offset;
+				std::uint32_t struct_type;  /* type record index */
+				std::uint32_t member_type;  /* type record index */
+				std::uint32_t column;
+				std::uint32_t reserved;
+			};
+
+			/* Sorted by key_hash, one per fallback column of ``frozen_scope`` */
+			struct fallback_record {
+				std::uint64_t key_hash;     /* of the struct and member type, see fallback_key_hash */
+				std::uint32_t column;
+				std::uint32_t reserved;
+			};
+
+			struct row_record {
+				std::uint64_t payload;      /* offset into the payloads section */
+				std::uint32_t parent;       /* npos for the root */
+				std::uint32_t type;         /* type record index, npos for the root */
+			};
+
+			constexpr std::uint64_t align_up(std::uint64_t value, std::uint64_t align) {
+				return (value + align - 1) / align * align;
+			}
+
+			inline std::uint64_t member_key_hash(std::uint64_t struct_hash, std::uint64_t member_hash, std::uint64_t offset) {
+				return fnv1a(offset, fnv1a(member_hash, fnv1a(struct_hash, 0xcbf29ce484222325ULL)));
+			}
+
+			/* Hashes are 0 for no struct type and for member types without a type column */
+			inline std::uint64_t fallback_key_hash(std::uint64_t struct_hash, std::uint64_t member_hash) {
+				return member_key_hash(struct_hash, member_hash, ~std::uint64_t{ 0 });
+			}
+
+		}
+
+		/* Read-only view of a whole file, unmapped on destruction */
+		class file_mapping {
+		public:
+			file_mapping() = default;
+
+			explicit file_mapping(const std::string& path) {
+#ifdef _WIN32
+				HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (file == INVALID_HANDLE_VALUE) {
+					raise("Could not open " + path);
+				}
+				LARGE_INTEGER file_size{};
+				if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+					CloseHandle(file);
+					raise("Could not map " + path);
+				}
+				HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				CloseHandle(file);
+				if (!mapping) {
+					raise("Could not map " + path);
+				}
+				/* The view keeps the mapping alive */
+				void* mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+				if (!mapped) {
+					raise("Could not map " + path);
+				}
+				view = static_cast<const unsigned char*>(mapped);
+				length = static_cast<std::size_t>(file_size.QuadPart);
+#else
+				const int file = ::open(path.c_str(), O_RDONLY);
+				if (file < 0) {
+					raise("Could not open " + path);
+				}
+				struct stat status {};
+				if (::fstat(file, &status) != 0 || status.st_size == 0) {
+					::close(file);
+					raise("Could not map " + path);
+				}
+				/* The mapping stays valid once the descriptor is closed */
+				void* mapped = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+				::close(file);
+				if (mapped == MAP_FAILED) {
+					raise("Could not map " + path);
+				}
+				view = static_cast<const unsigned char*>(mapped);
+				length = static_cast<std::size_t>(status.st_size);
+#endif
+			}
+
+			file_mapping(file_mapping&& other) noexcept : view(other.view), length(other.length) {
+				other.view = nullptr;
+				other.length = 0;
+			}
+			file_mapping& operator=(file_mapping&& other) noexcept {
+				std::swap(view, other.view);
+				std::swap(length, other.length);
+				return *this;
+			}
+			file_mapping(const file_mapping&) = delete;
+			file_mapping& operator=(const file_mapping&) = delete;
+
+			~file_mapping() {
+				if (!view) {
+					return;
+				}
+#ifdef _WIN32
+				UnmapViewOfFile(view);
+#else
+				::munmap(const_cast<unsigned char*>(view), length);
+#endif
+			}
+
+			const unsigned char* data() const { return view; }
+			std::size_t size() const { return length; }
+
+		private:
+			const unsigned char* view = nullptr;
+			std::size_t length = 0;
+		};
+
+		/* Writes frozen trees, friend of scope and frozen_scope */
+		template<template<class> class BaseTemplate>
+		struct binary_format {
+			using frozen_type = frozen_scope<BaseTemplate>;
+
+			static void save(const frozen_type& frozen, std::ostream& out) {
+				using namespace binary;
+
+				/* Every type the rows and member keys refer to, sorted by the hash they are found under */
+				std::vector<type_id> types;
+				std::vector<std::uint32_t> type_index; /* type id -> record, npos if not stored */
+				const auto add_type = [&](type_id type) {
+					if (type.value >= type_index.size()) {
+						type_index.resize(type.value + 1, npos);
+					}
+					if (type_index[type.value] == npos) {
+						type_index[type.value] = 0;
+						types.push_back(type);
+					}
+				};
+				for (type_id type : frozen.row_types) {
+					if (type.is_valid()) {
+						add_type(type);
+					}
+				}
+				for (const auto& key : frozen.member_column_keys) {
+					add_type(key.struct_type);
+					add_type(key.member_type);
+				}
+
+				std::vector<std::pair<std::uint64_t, type_id>> hashed;
+				hashed.reserve(types.size());
+				for (type_id type : types) {
+					hashed.emplace_back(type.hash(), type);
+				}
+				std::sort(hashed.begin(), hashed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+				/* Types are found by name hash when mapped, so two saved types must not share one */
+				for (std::size_t i = 1; i < hashed.size(); ++i) {
+					if (hashed[i].first == hashed[i - 1].first) {
+						raise("Type name collision between " + std::string(hashed[i - 1].second.name()) + " and " + std::string(hashed[i].second.name()));
+					}
+				}
+
+				std::vector<type_record> type_records(hashed.size());
+				std::string names;
+				for (std::uint32_t i = 0; i < hashed.size(); ++i) {
+					const type_id type = hashed[i].second;
+					const std::string_view name = type.name();
+					type_index[type.value] = i;
+
+					type_record& record = type_records[i];
+					record.name_hash = hashed[i].first;
+					record.name_offset = static_cast<std::uint32_t>(names.size());
+					record.name_size = static_cast<std::uint32_t>(name.size());
+					names += name;
+					const bool has_column = type.value < frozen.type_columns.size() && frozen.type_columns[type.value] != npos;
+					record.column = has_column ? frozen.type_columns[type.value] : npos;
+				}
+
+				/* Payload layouts come with the rows, struct types that only key members have none */
+				std::uint64_t payload_align = section_align;
+				std::vector<row_record> rows(frozen.nodes.size());
+				std::uint64_t payload_size = 0;
+				for (std::size_t row = 0; row < rows.size(); ++row) {
+					const auto* node = frozen.nodes[row];
+					rows[row].parent = node->parent ? frozen.rows.at(node->parent) : npos;
+					rows[row].type = npos;
+					rows[row].payload = 0;
+
+					const auto* ops = frozen.row_ops[row];
+					if (!ops) {
+						continue;
+					}
+					type_record& record = type_records[type_index[frozen.row_types[row].value]];
+					rows[row].type = type_index[frozen.row_types[row].value];
+					record.payload_size = static_cast<std::uint32_t>(ops->payload_size);
+					record.signature = ops->payload_signature();
+					payload_align = std::max<std::uint64_t>(payload_align, ops->payload_align);
+					payload_size = align_up(payload_size, ops->payload_align);
+					rows[row].payload = payload_size;
+					payload_size += ops->payload_size;
+				}
+
+				std::vector<unsigned char> payloads(static_cast<std::size_t>(payload_size), 0);
+				for (std::size_t row = 0; row < rows.size(); ++row) {
+					if (const auto* ops = frozen.row_ops[row]) {
+						ops->save(*frozen.nodes[row], payloads.data() + rows[row].payload);
+					}
+				}
+
+				const std::uint32_t type_columns = static_cast<std::uint32_t>(frozen.type_column_keys.size());
+				std::vector<member_record> members(frozen.member_column_keys.size());
+				for (std::uint32_t column = 0; column < members.size(); ++column) {
+					const auto& key = frozen.member_column_keys[column];
+					member_record& record = members[column];
+					record.struct_type = type_index[key.struct_type.value];
+					record.member_type = type_index[key.member_type.value];
+					record.offset = key.offset;
+					record.column = type_columns + column;
+					record.reserved = 0;
+					record.key_hash = member_key_hash(type_records[record.struct_type].name_hash, type_records[record.member_type].name_hash, record.offset);
+				}
+				std::sort(members.begin(), members.end(), [](const member_record& a, const member_record& b) { return a.key_hash < b.key_hash; });
+				for (std::size_t i = 1; i < members.size(); ++i) {
+					if (members[i].key_hash == members[i - 1].key_hash) {
+						const type_record& owner = type_records[members[i].struct_type];
+						raise("Member key hash collision in " + names.substr(owner.name_offset, owner.name_size));
+					}
+				}
+
+				std::vector<fallback_record> fallbacks(frozen.fallbacks.size());
+				for (std::size_t i = 0; i < fallbacks.size(); ++i) {
+					const auto& key = frozen.fallbacks[i];
+					fallback_record& record = fallbacks[i];
+					record.key_hash = fallback_key_hash(key.struct_type.is_valid() ? key.struct_type.hash() : 0, key.member_type.is_valid() ? key.member_type.hash() : 0);
+					record.column = key.column;
+					record.reserved = 0;
+				}
+				std::sort(fallbacks.begin(), fallbacks.end(), [](const fallback_record& a, const fallback_record& b) { return a.key_hash < b.key_hash; });
+				for (std::size_t i = 1; i < fallbacks.size(); ++i) {
+					if (fallbacks[i].key_hash == fallbacks[i - 1].key_hash) {
+						raise("Fallback key hash collision");
+					}
+				}
+
+				header head{};
+				std::memcpy(head.magic, magic, sizeof(magic));
+				head.version = version;
+				head.byte_order = byte_order;
+				head.origin = frozen.origin;
+				head.rows = static_cast<std::uint32_t>(rows.size());
+				head.types = static_cast<std::uint32_t>(type_records.size());
+				head.members = static_cast<std::uint32_t>(members.size());
+				head.type_columns = type_columns;
+				head.payload_align = static_cast<std::uint32_t>(payload_align);
+				head.fallbacks = static_cast<std::uint32_t>(fallbacks.size());
+				head.types_offset = align_up(sizeof(header), section_align);
+				head.members_offset = align_up(head.types_offset + type_records.size() * sizeof(type_record), section_align);
+				head.fallbacks_offset = align_up(head.members_offset + members.size() * sizeof(member_record), section_align);
+				head.rows_offset = align_up(head.fallbacks_offset + fallbacks.size() * sizeof(fallback_record), section_align);
+				head.table_offset = align_up(head.rows_offset + rows.size() * sizeof(row_record), section_align);
+				head.names_offset = align_up(head.table_offset + frozen.table.size() * sizeof(std::uint32_t), section_align);
+				head.payloads_offset = align_up(head.names_offset + names.size(), payload_align);
+				head.size = head.payloads_offset + payloads.size();
+
+				std::uint64_t written = 0;
+				const auto write = [&](std::uint64_t offset, const void* data, std::size_t size) {
+					static const char padding[64] = {};
+					while (written < offset) {
+						const std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(offset - written, sizeof(padding)));
+						out.write(padding, static_cast<std::streamsize>(chunk));
+						written += chunk;
+					}
+					out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+					written += size;
+				};
+				write(0, &head, sizeof(head));
+				write(head.types_offset, type_records.data(), type_records.size() * sizeof(type_record));
+				write(head.members_offset, members.data(), members.size() * sizeof(member_record));
+				write(head.fallbacks_offset, fallbacks.data(), fallbacks.size() * sizeof(fallback_record));
+				write(head.rows_offset, rows.data(), rows.size() * sizeof(row_record));
+				write(head.table_offset, frozen.table.data(), frozen.table.size() * sizeof(std::uint32_t));
+				write(head.names_offset, names.data(), names.size());
+				write(head.payloads_offset, payloads.data(), payloads.size());
+				if (!out) {
+					raise("Could not write scope tree");
+				}
+			}
+
+			template<auto member>
+			static const auto& member_key() {
+				return scope<BaseTemplate>::template member_key<member>().key;
+			}
+		};
+	}
+
+	/// <summary>
+	/// Save a frozen tree, resolving lookups from the scope it was frozen at.
+	/// Settings keep the fields listed in their ``reflect`` specialization.
+	/// </summary>
+	/// <param name="tree">Snapshot to save</param>
+	/// <param name="out">Binary stream to write to</param>
+	/// <exception cref="std::runtime_error">If two saved types have the same name hash or the stream fails</exception>
+	template<template<class> class BaseTemplate>
+	void save_binary(const frozen_scope<BaseTemplate>& tree, std::ostream& out) {
+		detail::binary_format<BaseTemplate>::save(tree, out);
+	}
+
+	/// <summary>
+	/// Save a tree, resolving lookups from the given scope.
+	/// </summary>
+	/// <param name="tree">Scope to save, with the rest of its tree</param>
+	/// <param name="out">Binary stream to write to</param>
+	template<template<class> class BaseTemplate>
+	void save_binary(const scope<BaseTemplate>& tree, std::ostream& out) {
+		save_binary(tree.freeze(), out);
+	}
+
+	/// <summary>
+	/// Save a tree to a file, to be opened with ``mapped_tree``.
+	/// </summary>
+	/// <param name="tree">Scope to save, with the rest of its tree</param>
+	/// <param name="path">File to create or overwrite</param>
+	template<template<class> class BaseTemplate>
+	void save_binary(const scope<BaseTemplate>& tree, const std::string& path) {
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			detail::raise("Could not open " + path);
+		}
+		save_binary(tree, out);
+		out.flush();
+		if (!out) {
+			detail::raise("Could not write " + path);
+		}
+	}
+
+	/// <summary>
+	/// Settings of one scope in a mapped tree. Reads the saved fields in place, the file is never copied.
+	/// Valid as long as the tree it came from.
+	/// </summary>
+	template<class Settings>
+	class mapped_settings {
+		using payload = detail::payload<Settings>;
+	public:
+		mapped_settings() = default;
+
+		/* Whether settings were found */
+		explicit operator bool() const { return data != nullptr; }
+
+		/// <summary>
+		/// Reference to a saved field, inside the mapped file.
+		/// </summary>
+		/// <typeparam name="field">Member pointer listed in ``reflect&lt;Settings&gt;``</typeparam>
+		template<auto field>
+		const auto& get() const {
+			constexpr std::size_t index = payload::template index_of<field>();
+			static_assert(index < payload::count, "Field is not listed in svh::reflect of the settings");
+			using value_type = typename payload::template field_type<index>;
+			return *reinterpret_cast<const value_type*>(data + payload::offsets[index]);
+		}
+
+		/// <summary>
+		/// Copy the saved fields into default constructed settings.
+		/// </summary>
+		Settings load() const {
+			Settings settings;
+			payload::read(data, settings);
+			return settings;
+		}
+
+	private:
+		template<template<class> class>
+		friend class mapped_tree;
+
+		explicit mapped_settings(const unsigned char* data) : data(data) {}
+
+		const unsigned char* data = nullptr;
+	};
+
+	/// <summary>
+	/// Read-only scope tree used in place from a file written by ``save_binary``, or from a buffer holding one.
+	/// Lookups resolve the same way as in the tree that was saved, members that were never pushed included.
+	/// </summary>
+	template<template<class> class BaseTemplate>
+	class mapped_tree {
+		using header = detail::binary::header;
+		using type_record = detail::binary::type_record;
+		using member_record = detail::binary::member_record;
+		using fallback_record = detail::binary::fallback_record;
+		using row_record = detail::binary::row_record;
+
+		static constexpr std::uint32_t mismatch = detail::npos - 1; /* same sentinel as frozen_scope */
+	public:
+
+		/// <summary>
+		/// Handle to a single scope inside the mapped tree.
+		/// </summary>
+		class node {
+		public:
+			/// <summary>
+			/// Find the settings for type T as seen from this scope.
+			/// </summary>
+			/// <typeparam name="T">The type of the settings to find</typeparam>
+			/// <returns>The settings, empty if not found</returns>
+			/// <exception cref="std::runtime_error">If the resolved scope has an unexpected type or a different layout</exception>
+			template<class T>
+			mapped_settings<BaseTemplate<simplify_t<T>>> find() const {
+				const std::uint32_t row = owner->resolve_type(index, type_hash<simplify_t<T>>());
+				return row == detail::npos ? mapped_settings<BaseTemplate<simplify_t<T>>>{} : owner->template settings_at<simplify_t<T>>(row);
+			}
+
+			/// <summary>
+			/// Get the settings for type T as seen from this scope.
+			/// </summary>
+			/// <typeparam name="T">The type of the settings to get</typeparam>
+			/// <exception cref="std::runtime_error">If not found</exception>
+			template<class T>
+			mapped_settings<BaseTemplate<simplify_t<T>>> get() const {
+				return owner->template settings_at<simplify_t<T>>(at<T>().index);
+			}
+
+			template<class T, class U, class... Rest>
+			auto get() const {
+				return at<T>().template get<U, Rest...>();
+			}
+
+			/// <summary>
+			/// Move to the scope that holds the settings for type T, to continue looking up from there.
+			/// </summary>
+			/// <exception cref="std::runtime_error">If not found</exception>
+			template<class T>
+			node at() const {
+				return owner->checked(owner->resolve_type(index, type_hash<simplify_t<T>>()));
+			}
+
+			template<class T, class U, class... Rest>
+			node at() const {
+				return at<T>().template at<U, Rest...>();
+			}
+
+			/// <summary>
+			/// Get member settings as seen from this scope.
+			/// </summary>
+			/// <typeparam name="member">Auto-deduced member pointer</typeparam>
+			/// <exception cref="std::runtime_error">If not found</exception>
+			template<auto member>
+			auto get_member() const {
+				using MemberType = typename member_pointer_traits<decltype(member)>::member_type;
+				return owner->template settings_at<MemberType>(at_member<member>().index);
+			}
+
+			/// <summary>
+			/// Move to the scope that holds the settings for a member.
+			/// </summary>
+			/// <exception cref="std::runtime_error">If not found</exception>
+			template<auto member>
+			node at_member() const {
+				using traits = member_pointer_traits<decltype(member)>;
+				using MemberType = typename traits::member_type;
+				static const std::uint64_t key_hash = detail::binary::member_key_hash(
+					type_hash<typename traits::class_type>(),
+					type_hash<MemberType>(),
+					detail::binary_format<BaseTemplate>::template member_key<member>().offset);
+				return owner->checked(owner->resolve_member(index, key_hash, type_hash<typename traits::class_type>(), type_hash<MemberType>()));
+			}
+
+			bool has_parent() const { return owner->rows[index].parent != detail::npos; }
+
+			/// <summary>
+			/// The scope this one was pushed in.
+			/// </summary>
+			/// <exception cref="std::runtime_error">If this is the root</exception>
+			node parent() const {
+				if (!has_parent()) {
+					detail::raise("Root has no parent");
+				}
+				return node(owner, owner->rows[index].parent);
+			}
+
+		private:
+			friend class mapped_tree;
+
+			node(const mapped_tree* owner, std::uint32_t index) : owner(owner), index(index) {}
+
+			const mapped_tree* owner;
+			std::uint32_t index;
+		};
+
+		/// <summary>
+		/// Map a file written by ``save_binary``.
+		/// </summary>
+		/// <exception cref="std::runtime_error">If the file cannot be mapped or is not a valid tree</exception>
+		explicit mapped_tree(const std::string& path) : mapping(path) {
+			open(mapping.data(), mapping.size());
+		}
+
+		/// <summary>
+		/// Use a buffer holding a saved tree, which must outlive the tree.
+		/// The buffer must be aligned like the file was written, 8 bytes is enough unless settings hold over-aligned fields.
+		/// </summary>
+		/// <exception cref="std::runtime_error">If the buffer is not a valid tree</exception>
+		mapped_tree(const void* data, std::size_t size) {
+			open(static_cast<const unsigned char*>(data), size);
+		}
+
+		/// <summary>
+		/// Handle to the scope the tree was saved from.
+		/// </summary>
+		node root() const {
+			return node(this, head.origin);
+		}
+
+		template<class T>
+		auto find() const {
+			return root().template find<T>();
+		}
+
+		template<class... T>
+		auto get() const {
+			return root().template get<T...>();
+		}
+
+		template<class... T>
+		node at() const {
+			return root().template at<T...>();
+		}
+
+		template<auto member>
+		auto get_member() const {
+			return root().template get_member<member>();
+		}
+
+		/// <summary>
+		/// Number of scopes in the tree.
+		/// </summary>
+		std::size_t size() const {
+			return head.rows;
+		}
+
+	private:
+		void open(const unsigned char* data, std::size_t size) {
+			using namespace detail::binary;
+			if (!data || size < sizeof(header) || reinterpret_cast<std::uintptr_t>(data) % section_align != 0) {
+				detail::raise("Invalid scope tree: buffer too small or misaligned");
+			}
+			std::memcpy(&head, data, sizeof(header));
+			if (std::memcmp(head.magic, magic, sizeof(magic)) != 0 || head.version != version || head.byte_order != byte_order) {
+				detail::raise("Invalid scope tree: unknown format, version or byte order");
+			}
+			if (head.size != size || head.payload_align == 0 || reinterpret_cast<std::uintptr_t>(data) % head.payload_align != 0) {
+				detail::raise("Invalid scope tree: size or alignment does not match");
+			}
+
+			const auto fits = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t record) {
+				return offset % section_align == 0 && offset <= size && count <= (size - offset) / record;
+			};
+			width = static_cast<std::uint64_t>(head.type_columns) + head.members + head.fallbacks;
+			if (head.rows == 0 || head.origin >= head.rows
+				|| !fits(head.types_offset, head.types, sizeof(type_record))
+				|| !fits(head.members_offset, head.members, sizeof(member_record))
+				|| !fits(head.fallbacks_offset, head.fallbacks, sizeof(fallback_record))
+				|| !fits(head.rows_offset, head.rows, sizeof(row_record))
+				|| (width != 0 && !fits(head.table_offset, head.rows, width * sizeof(std::uint32_t)))
+				|| head.names_offset > head.payloads_offset || head.payloads_offset > size) {
+				detail::raise("Invalid scope tree: sections out of bounds");
+			}
+
+			types = reinterpret_cast<const type_record*>(data + head.types_offset);
+			members = reinterpret_cast<const member_record*>(data + head.members_offset);
+			fallbacks = reinterpret_cast<const fallback_record*>(data + head.fallbacks_offset);
+			rows = reinterpret_cast<const row_record*>(data + head.rows_offset);
+			table = reinterpret_cast<const std::uint32_t*>(data + head.table_offset);
+			payloads = data + head.payloads_offset;
+
+			const std::uint64_t payload_bytes = size - head.payloads_offset;
+			for (std::uint32_t i = 0; i < head.types; ++i) {
+				if (types[i].column != detail::npos && types[i].column >= head.type_columns) {
+					detail::raise("Invalid scope tree: type column out of bounds");
+				}
+			}
+			for (std::uint32_t i = 0; i < head.members; ++i) {
+				if (members[i].struct_type >= head.types || members[i].member_type >= head.types || members[i].column >= width) {
+					detail::raise("Invalid scope tree: member out of bounds");
+				}
+			}
+			for (std::uint32_t i = 0; i < head.fallbacks; ++i) {
+				if (fallbacks[i].column >= width) {
+					detail::raise("Invalid scope tree: fallback column out of bounds");
+				}
+			}
+			for (std::uint32_t i = 0; i < head.rows; ++i) {
+				const row_record& row = rows[i];
+				const bool root_row = row.type == detail::npos;
+				if ((row.parent != detail::npos && row.parent >= head.rows) || (root_row != (row.parent == detail::npos))
+					|| (!root_row && (row.type >= head.types || row.payload > payload_bytes || types[row.type].payload_size > payload_bytes - row.payload))) {
+					detail::raise("Invalid scope tree: row out of bounds");
+				}
+			}
+		}
+
+		/* Record of the type stored under hash, nullptr if the tree has none */
+		const type_record* find_type(std::uint64_t hash) const {
+			const type_record* end = types + head.types;
+			const type_record* it = std::lower_bound(types, end, hash, [](const type_record& record, std::uint64_t value) { return record.name_hash < value; });
+			return it != end && it->name_hash == hash ? it : nullptr;
+		}
+
+		std::uint32_t cell(std::uint32_t row, std::uint32_t column) const {
+			const std::uint32_t found = table[row * width + column];
+			if (found != detail::npos && found != mismatch && found >= head.rows) {
+				detail::raise("Invalid scope tree: cell out of bounds");
+			}
+			return found;
+		}
+
+		std::uint32_t resolve_type(std::uint32_t row, std::uint64_t hash) const {
+			const type_record* type = find_type(hash);
+			return type && type->column != detail::npos ? cell(row, type->column) : detail::npos;
+		}
+
+		std::uint32_t resolve_member(std::uint32_t row, std::uint64_t key_hash, std::uint64_t struct_type, std::uint64_t member_type) const {
+			const member_record* end = members + head.members;
+			const member_record* it = std::lower_bound(members, end, key_hash, [](const member_record& record, std::uint64_t value) { return record.key_hash < value; });
+			if (it != end && it->key_hash == key_hash) {
+				return cell(row, it->column);
+			}
+
+			/* Member is not stored in the tree, resolve it through the fallback columns like frozen_scope */
+			const type_record* type = find_type(member_type);
+			const bool has_column = type && type->column != detail::npos;
+			const std::uint64_t member_hash = has_column ? member_type : 0;
+			const fallback_record* fallback = find_fallback(detail::binary::fallback_key_hash(struct_type, member_hash));
+			if (!fallback) {
+				fallback = find_fallback(detail::binary::fallback_key_hash(0, member_hash));
+			}
+			const std::uint32_t column = fallback ? fallback->column : has_column ? type->column : detail::npos;
+			if (column == detail::npos) {
+				return detail::npos;
+			}
+
+			/* Fallback cells hold the resolved row whatever its type */
+			const std::uint32_t found = cell(row, column);
+			if (found == detail::npos || found == mismatch) {
+				return found;
+			}
+			return type && rows[found].type == static_cast<std::uint32_t>(type - types) ? found : mismatch;
+		}
+
+		const fallback_record* find_fallback(std::uint64_t key_hash) const {
+			const fallback_record* end = fallbacks + head.fallbacks;
+			const fallback_record* it = std::lower_bound(fallbacks, end, key_hash, [](const fallback_record& record, std::uint64_t value) { return record.key_hash < value; });
+			return it != end && it->key_hash == key_hash ? it : nullptr;
+		}
+
+		node checked(std::uint32_t row) const {
+			if (row == detail::npos) {
+				detail::raise("Type not found");
+			}
+			if (row == mismatch) {
+				detail::raise("Existing child has unexpected type");
+			}
+			return node(this, row);
+		}
+
+		template<class T>
+		mapped_settings<BaseTemplate<T>> settings_at(std::uint32_t row) const {
+			using payload = detail::payload<BaseTemplate<T>>;
+			static const std::uint64_t signature = payload::signature();
+			if (row == mismatch) {
+				detail::raise("Existing child has unexpected type");
+			}
+			if (rows[row].type == detail::npos) {
+				detail::raise("Invalid scope tree: cell resolves to the root");
+			}
+			const type_record& type = types[rows[row].type];
+			if (type.signature != signature || type.payload_size != payload::size) {
+				detail::raise("Saved settings do not match the reflected fields of their type");
+			}
+			return mapped_settings<BaseTemplate<T>>(payloads + rows[row].payload);
+		}
+
+		detail::file_mapping mapping; /* empty for buffers */
+		header head{};
+		std::uint64_t width = 0;
+		const type_record* types = nullptr;
+		const member_record* members = nullptr;
+		const fallback_record* fallbacks = nullptr;
+		const row_record* rows = nullptr;
+		const std::uint32_t* table = nullptr;
+		const unsigned char* payloads = nullptr;
+	};
+}
@@ -0,0 +1,842 @@
+#pragma once
+#include "scope.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+JSON text of scope trees, written with ``save_json`` and read back with ``load_json``.
+Types and members are written under the names given in a ``json_registry``, settings with the fields listed in ``reflect``:
+{
+	"version": 1,
+	"children": [
+		{
+			"type": "MyStruct",
+			"children": [
+				{
+					"type": "int",
+					"fields": { "min": 0, "max": 20 }
+				}
+			]
+		}
+	]
+}
+Loading pushes every node like ``push``, so settings start from what the parents resolve to and only the saved fields are overwritten.
+The text is read as it streams in and never held as a whole, memory grows with the nesting depth only.
+*/
+namespace svh {
+	template<template<class> class BaseTemplate>
+	class json_registry;
+
+	namespace detail {
+		namespace json {
+			constexpr int version = 1;
+			constexpr std::size_t max_depth = 256; /* Nodes nested deeper are rejected, loading recurses once per level */
+
+			/* A value that is not an object or array, text points into the reader */
+			struct scalar {
+				enum class kind { number, string, boolean, null };
+
+				kind type = kind::null;
+				std::string_view text;
+				bool flag = false;
+			};
+
+			enum class field_result { set, unknown, invalid };
+
+			/* Collects the text in a fixed buffer, the stream only sees large writes */
+			class writer {
+			public:
+				explicit writer(std::ostream& out) : out(out) {}
+				writer(const writer&) = delete;
+				writer& operator=(const writer&) = delete;
+				~writer() { flush(); }
+
+				void raw(std::string_view text) {
+					if (text.size() > sizeof(buffer) - used) {
+						flush();
+						if (text.size() > sizeof(buffer)) {
+							out.write(text.data(), static_cast<std::streamsize>(text.size()));
+							return;
+						}
+					}
+					std::memcpy(buffer + used, text.data(), text.size());
+					used += text.size();
+				}
+
+				void put(char c) {
+					if (used == sizeof(buffer)) {
+						flush();
+					}
+					buffer[used++] = c;
+				}
+
+				void flush() {
+					out.write(buffer, static_cast<std::streamsize>(used));
+					used = 0;
+				}
+
+				void indent(int depth) {
+					static constexpr char tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+					for (; depth > 0; depth -= 16) {
+						raw(std::string_view(tabs, static_cast<std::size_t>(depth < 16 ? depth : 16)));
+					}
+				}
+
+				/* Runs without characters to escape are written in one call */
+				void string(std::string_view text) {
+					put('"');
+					std::size_t run = 0;
+					for (std::size_t i = 0; i < text.size(); ++i) {
+						const char c = text[i];
+						if (c != '"' && c != '\\' && static_cast<unsigned char>(c) >= 0x20) {
+							continue;
+						}
+						raw(text.substr(run, i - run));
+						run = i + 1;
+						switch (c) {
+						case '"': raw("\\\""); break;
+						case '\\': raw("\\\\"); break;
+						case '\n': raw("\\n"); break;
+						case '\r': raw("\\r"); break;
+						case '\t': raw("\\t"); break;
+						default: {
+							char escaped[8];
+							std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+							raw(escaped);
+						}
+						}
+					}
+					raw(text.substr(run));
+					put('"');
+				}
+
+				/* Key followed by the separator */
+				void key(std::string_view name) {
+					string(name);
+					raw(": ");
+				}
+
+				template<class T>
+				void value(const T& value) {
+					if constexpr (std::is_same_v<T, bool>) {
+						raw(value ? "true" : "false");
+					} else if constexpr (std::is_enum_v<T>) {
+						this->value(static_cast<std::underlying_type_t<T>>(value));
+					} else if constexpr (std::is_integral_v<T>) {
+						char text[32];
+						const auto end = std::to_chars(text, text + sizeof(text), value).ptr;
+						raw(std::string_view(text, static_cast<std::size_t>(end - text)));
+					} else if constexpr (std::is_floating_point_v<T>) {
+						/* JSON has no infinities or NaN, loading null keeps the inherited value */
+						if (!std::isfinite(value)) {
+							raw("null");
+							return;
+						}
+						/* Shortest text that reads back to the same value, independent of the C locale */
+						char text[64];
+						const auto end = std::to_chars(text, text + sizeof(text), value).ptr;
+						raw(std::string_view(text, static_cast<std::size_t>(end - text)));
+					} else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+						string(value);
+					} else {
+						static_assert(sizeof(T) == 0, "Reflected fields saved as JSON must be arithmetic, enums or strings");
+					}
+				}
+
+				bool good() {
+					flush();
+					return static_cast<bool>(out);
+				}
+
+			private:
+				std::ostream& out;
+				char buffer[4096];
+				std::size_t used = 0;
+			};
+
+			template<class T>
+			bool read_value(const scalar& in, T& value) {
+				if constexpr (std::is_same_v<T, bool>) {
+					if (in.type != scalar::kind::boolean) {
+						return false;
+					}
+					value = in.flag;
+					return true;
+				} else if constexpr (std::is_enum_v<T>) {
+					std::underlying_type_t<T> underlying{};
+					if (!read_value(in, underlying)) {
+						return false;
+					}
+					value = static_cast<T>(underlying);
+					return true;
+				} else if constexpr (std::is_arithmetic_v<T>) {
+					if (in.type != scalar::kind::number) {
+						return false;
+					}
+					/* from_chars ignores the C locale, so "1.5" reads the same everywhere */
+					const char* end = in.text.data() + in.text.size();
+					T parsed{};
+					const auto result = std::from_chars(in.text.data(), end, parsed);
+					if (result.ec != std::errc() || result.ptr != end) {
+						return false;
+					}
+					value = parsed;
+					return true;
+				} else if constexpr (std::is_assignable_v<T&, std::string_view>) {
+					if (in.type != scalar::kind::string) {
+						return false;
+					}
+					value = in.text;
+					return true;
+				} else {
+					static_assert(sizeof(T) == 0, "Reflected fields loaded from JSON must be arithmetic, enums or strings");
+				}
+			}
+
+			/* Pull parser over a stream buffer, reads one character at a time and keeps only the current token */
+			class reader {
+			public:
+				explicit reader(std::istream& in) : in(in.rdbuf()) {
+					if (!this->in) {
+						raise("JSON stream has no buffer");
+					}
+				}
+
+				[[noreturn]] void fail(const std::string& message) const {
+					raise("JSON line " + std::to_string(line) + ": " + message);
+				}
+
+				void expect(char c) {
+					if (!consume(c)) {
+						fail(std::string("Expected '") + c + "'");
+					}
+				}
+
+				/* Skip whitespace, then take c if it is next */
+				bool consume(char c) {
+					skip_space();
+					if (peek() != c) {
+						return false;
+					}
+					get();
+					return true;
+				}
+
+				/* Whether the object or array that was opened continues after an element, consumes the separator or the closing bracket */
+				bool next(char close) {
+					if (consume(',')) {
+						return true;
+					}
+					expect(close);
+					return false;
+				}
+
+				/* Object key and its ':' */
+				const std::string& read_key() {
+					read_string(key_buffer);
+					expect(':');
+					return key_buffer;
+				}
+
+				const std::string& read_string() {
+					read_string(text_buffer);
+					return text_buffer;
+				}
+
+				scalar read_scalar() {
+					skip_space();
+					const int c = peek();
+					if (c == '"') {
+						read_string(text_buffer);
+						return { scalar::kind::string, text_buffer };
+					}
+					if (c == '-' || (c >= '0' && c <= '9')) {
+						text_buffer.clear();
+						for (int n = peek(); n == '-' || n == '+' || n == '.' || n == 'e' || n == 'E' || (n >= '0' && n <= '9'); n = peek()) {
+							text_buffer.push_back(static_cast<char>(get()));
+						}
+						return { scalar::kind::number, text_buffer };
+					}
+					if (literal("true")) {
+						return { scalar::kind::boolean, {}, true };
+					}
+					if (literal("false")) {
+						return { scalar::kind::boolean, {}, false };
+					}
+					if (literal("null")) {
+						return { scalar::kind::null, {}, false };
+					}
+					fail("Expected a value");
+				}
+
+				/* Skip a value of any kind, nesting is tracked with a counter */
+				void skip() {
+					skip_space();
+					if (peek() != '{' && peek() != '[') {
+						read_scalar();
+						return;
+					}
+					std::size_t depth = 0;
+					do {
+						skip_space();
+						const int c = peek();
+						if (c == std::char_traits<char>::eof()) {
+							fail("Unexpected end of input");
+						}
+						if (c == '"') {
+							read_string(text_buffer);
+							continue;
+						}
+						get();
+						if (c == '{' || c == '[') {
+							++depth;
+						} else if (c == '}' || c == ']') {
+							--depth;
+						}
+					} while (depth > 0);
+				}
+
+				/* Only whitespace may follow the document */
+				void finish() {
+					skip_space();
+					if (peek() != std::char_traits<char>::eof()) {
+						fail("Unexpected text after the tree");
+					}
+				}
+
+			private:
+				int peek() {
+					return in->sgetc();
+				}
+
+				int get() {
+					const int c = in->sbumpc();
+					if (c == '\n') {
+						++line;
+					}
+					return c;
+				}
+
+				void skip_space() {
+					for (int c = peek(); c == ' ' || c == '\t' || c == '\n' || c == '\r'; c = peek()) {
+						get();
+					}
+				}
+
+				bool literal(const char* word) {
+					if (peek() != *word) {
+						return false;
+					}
+					for (; *word; ++word) {
+						if (get() != *word) {
+							fail("Invalid literal");
+						}
+					}
+					return true;
+				}
+
+				void read_string(std::string& out) {
+					expect('"');
+					out.clear();
+					for (;;) {
+						int c = get();
+						if (c == std::char_traits<char>::eof()) {
+							fail("Unterminated string");
+						}
+						if (c == '"') {
+							return;
+						}
+						if (c != '\\') {
+							out.push_back(static_cast<char>(c));
+							continue;
+						}
+						switch (c = get()) {
+						case '"': case '\\': case '/': out.push_back(static_cast<char>(c)); break;
+						case 'b': out.push_back('\b'); break;
+						case 'f': out.push_back('\f'); break;
+						case 'n': out.push_back('\n'); break;
+						case 'r': out.push_back('\r'); break;
+						case 't': out.push_back('\t'); break;
+						case 'u': append_utf8(out, read_code_point()); break;
+						default: fail("Invalid escape");
+						}
+					}
+				}
+
+				std::uint32_t read_hex4() {
+					std::uint32_t value = 0;
+					for (int i = 0; i < 4; ++i) {
+						const int c = get();
+						value <<= 4;
+						if (c >= '0' && c <= '9') {
+							value |= static_cast<std::uint32_t>(c - '0');
+						} else if (c >= 'a' && c <= 'f') {
+							value |= static_cast<std::uint32_t>(c - 'a' + 10);
+						} else if (c >= 'A' && c <= 'F') {
+							value |= static_cast<std::uint32_t>(c - 'A' + 10);
+						} else {
+							fail("Invalid unicode escape");
+						}
+					}
+					return value;
+				}
+
+				std::uint32_t read_code_point() {
+					const std::uint32_t high = read_hex4();
+					if (high < 0xd800 || high > 0xdbff) {
+						return high;
+					}
+					/* Surrogate pair */
+					if (get() != '\\' || get() != 'u') {
+						fail("Invalid unicode escape");
+					}
+					const std::uint32_t low = read_hex4();
+					if (low < 0xdc00 || low > 0xdfff) {
+						fail("Invalid unicode escape");
+					}
+					return 0x10000 + ((high - 0xd800) << 10) + (low - 0xdc00);
+				}
+
+				static void append_utf8(std::string& out, std::uint32_t code) {
+					if (code < 0x80) {
+						out.push_back(static_cast<char>(code));
+					} else if (code < 0x800) {
+						out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+						out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+					} else if (code < 0x10000) {
+						out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+						out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+						out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+					} else {
+						out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+						out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+						out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+						out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+					}
+				}
+
+				std::streambuf* in;
+				std::size_t line = 1;
+				std::string key_buffer;
+				std::string text_buffer;
+			};
+
+			template<class Settings, std::size_t... I>
+			void write_fields(const Settings& settings, writer& out, std::index_sequence<I...>) {
+				constexpr const auto& fields = reflect<Settings>::fields;
+				std::size_t written = 0;
+				((out.raw(written++ == 0 ? "" : ", "), out.key(std::get<I>(fields).name), out.value(settings.*std::get<I>(fields).pointer)), ...);
+				(void)written;
+				(void)settings;
+				(void)out;
+			}
+
+			template<class Settings, std::size_t... I>
+			field_result read_field(Settings& settings, std::string_view name, const scalar& value, std::index_sequence<I...>) {
+				constexpr const auto& fields = reflect<Settings>::fields;
+				field_result result = field_result::unknown;
+				((result == field_result::unknown && name == std::get<I>(fields).name
+					? (result = read_value(value, settings.*std::get<I>(fields).pointer) ? field_result::set : field_result::invalid)
+					: result), ...);
+				(void)settings;
+				(void)name;
+				(void)value;
+				return result;
+			}
+		}
+
+		/* Walks trees for save_json and builds them for load_json, friend of scope and json_registry */
+		template<template<class> class BaseTemplate>
+		struct json_format {
+			using scope_type = scope<BaseTemplate>;
+			using registry_type = json_registry<BaseTemplate>;
+			using type_entry = typename registry_type::type_entry;
+			using member_entry = typename registry_type::member_entry;
+
+			static void save(const scope_type& root, const registry_type& registry, json::writer& out) {
+				read_guard lock(root.state()); /* For the whole walk, like dump */
+				out.raw("{\n");
+				out.indent(1);
+				out.key("version");
+				out.value(json::version);
+				if (has_children(root)) {
+					out.raw(",\n");
+					out.indent(1);
+					write_children(root, registry, out, 1);
+				}
+				out.raw("\n}\n");
+			}
+
+			static void load(scope_type& root, const registry_type& registry, json::reader& in) {
+				in.expect('{');
+				if (!in.consume('}')) {
+					do {
+						const std::string& key = in.read_key();
+						if (key == "version") {
+							const json::scalar value = in.read_scalar();
+							int version = 0;
+							if (!json::read_value(value, version) || version != json::version) {
+								in.fail("Unsupported version");
+							}
+						} else if (key == "children") {
+							read_children(root, registry, in, 1);
+						} else {
+							in.skip();
+						}
+					} while (in.next('}'));
+				}
+				in.finish();
+			}
+
+		private:
+			static bool has_children(const scope_type& node) {
+				return !node.view().children.empty() || !node.view().member_children.empty();
+			}
+
+			/* Children sorted by name, so the text does not depend on hash order or type id assignment */
+			static void write_children(const scope_type& node, const registry_type& registry, json::writer& out, int depth) {
+				struct item {
+					const std::string* name;
+					const type_entry* fields;
+					const scope_type* child;
+					bool member;
+				};
+				std::vector<item> items;
+				items.reserve(node.view().children.size() + node.view().member_children.size());
+				for (const auto& pair : node.view().children) {
+					const type_entry& entry = registry.type_of(pair.first);
+					items.push_back({ &entry.name, &entry, pair.second.get(), false });
+				}
+				for (const auto& pair : node.view().member_children) {
+					const member_entry& entry = registry.member_of(pair.first.struct_type, pair.first.member_type, pair.first.offset);
+					items.push_back({ &entry.name, &registry.type_of(pair.first.member_type), pair.second.get(), true });
+				}
+				std::sort(items.begin(), items.end(), [](const item& a, const item& b) {
+					return a.member != b.member ? b.member : *a.name < *b.name;
+				});
+
+				out.key("children");
+				out.raw("[\n");
+				for (std::size_t i = 0; i < items.size(); ++i) {
+					const item& current = items[i];
+					out.indent(depth + 1);
+					out.raw("{\n");
+					out.indent(depth + 2);
+					out.key(current.member ? "member" : "type");
+					out.string(*current.name);
+					if (current.fields->has_fields) {
+						out.raw(",\n");
+						out.indent(depth + 2);
+						out.key("fields");
+						out.raw("{ ");
+						current.fields->write_fields(*current.child, out);
+						out.raw(" }");
+					}
+					if (has_children(*current.child)) {
+						out.raw(",\n");
+						out.indent(depth + 2);
+						write_children(*current.child, registry, out, depth + 2);
+					}
+					out.raw("\n");
+					out.indent(depth + 1);
+					out.raw(i + 1 < items.size() ? "},\n" : "}\n");
+				}
+				out.indent(depth);
+				out.raw("]");
+			}
+
+			static void read_children(scope_type& parent, const registry_type& registry, json::reader& in, std::size_t depth) {
+				if (depth > json::max_depth) {
+					in.fail("Nodes nested deeper than " + std::to_string(json::max_depth) + " levels");
+				}
+				in.expect('[');
+				if (in.consume(']')) {
+					return;
+				}
+				do {
+					read_node(parent, registry, in, depth);
+				} while (in.next(']'));
+			}
+
+			/* The type or member has to come first, it is pushed right away so the rest of the node streams into it */
+			static void read_node(scope_type& parent, const registry_type& registry, json::reader& in, std::size_t depth) {
+				scope_type* node = nullptr;
+				const type_entry* fields = nullptr;
+				in.expect('{');
+				if (in.consume('}')) {
+					in.fail("Node without type or member");
+				}
+				do {
+					const std::string& key = in.read_key();
+					if (key == "type" || key == "member") {
+						if (node) {
+							in.fail("Node has more than one type or member");
+						}
+						const bool member = key == "member";
+						const std::string& name = in.read_string();
+						if (member) {
+							const member_entry* entry = registry.find_member(name);
+							if (!entry) {
+								in.fail("Unknown member " + name);
+							}
+							node = &entry->push(parent);
+							fields = &registry.type_of(entry->member_type);
+						} else {
+							fields = registry.find_type(name);
+							if (!fields) {
+								in.fail("Unknown type " + name);
+							}
+							node = &fields->push(parent);
+						}
+					} else if (key == "fields") {
+						if (!node) {
+							in.fail("Fields before the type or member of a node");
+						}
+						read_fields(*node, *fields, in);
+					} else if (key == "children") {
+						if (!node) {
+							in.fail("Children before the type or member of a node");
+						}
+						read_children(*node, registry, in, depth + 1);
+					} else {
+						in.skip();
+					}
+				} while (in.next('}'));
+				if (!node) {
+					in.fail("Node without type or member");
+				}
+			}
+
+			static void read_fields(scope_type& node, const type_entry& fields, json::reader& in) {
+				in.expect('{');
+				if (in.consume('}')) {
+					return;
+				}
+				do {
+					const std::string& name = in.read_key();
+					const json::scalar value = in.read_scalar();
+					if (value.type == json::scalar::kind::null) {
+						continue; /* Keep the inherited value */
+					}
+					switch (fields.read_field(node, name, value)) {
+					case json::field_result::unknown: in.fail("Unknown field " + name + " of " + fields.name);
+					case json::field_result::invalid: in.fail("Invalid value for field " + name + " of " + fields.name);
+					case json::field_result::set: break;
+					}
+				} while (in.next('}'));
+			}
+		};
+	}
+
+	/// <summary>
+	/// Names of the types and members that can be saved and loaded as JSON.
+	/// Every type and member in a saved tree must be registered, with the same names when loading it.
+	/// </summary>
+	template<template<class> class BaseTemplate>
+	class json_registry {
+		using scope_type = scope<BaseTemplate>;
+	public:
+		/// <summary>
+		/// Register the settings of T.
+		/// </summary>
+		/// <typeparam name="T">The type, as passed to push</typeparam>
+		/// <param name="name">Name in the text, defaults to ``type_name``</param>
+		/// <exception cref="std::runtime_error">If the name is taken by another type</exception>
+		template<class T>
+		json_registry& add(std::string name = std::string(type_name<simplify_t<T>>::value)) {
+			using settings_type = BaseTemplate<simplify_t<T>>;
+			using sequence = std::make_index_sequence<std::tuple_size_v<std::decay_t<decltype(reflect<settings_type>::fields)>>>;
+
+			const type_id id = type_id::of<simplify_t<T>>();
+			if (id.value < type_index.size() && type_index[id.value] != detail::npos) {
+				rename(types[type_index[id.value]], type_names, std::move(name));
+				return *this;
+			}
+
+			type_entry entry;
+			entry.name = std::move(name);
+			entry.has_fields = sequence::size() > 0;
+			entry.push = [](scope_type& parent) -> scope_type& { return parent.template push<simplify_t<T>>(); };
+			entry.write_fields = [](const scope_type& node, detail::json::writer& out) {
+				detail::json::write_fields(static_cast<const settings_type&>(node), out, sequence{});
+			};
+			entry.read_field = [](scope_type& node, std::string_view field, const detail::json::scalar& value) {
+				return detail::json::read_field(static_cast<settings_type&>(node), field, value, sequence{});
+			};
+			claim(type_names, entry.name, static_cast<std::uint32_t>(types.size()));
+			if (id.value >= type_index.size()) {
+				type_index.resize(id.value + 1, detail::npos);
+			}
+			type_index[id.value] = static_cast<std::uint32_t>(types.size());
+			types.push_back(std::move(entry));
+			return *this;
+		}
+
+		template<class T, class U, class... Rest>
+		json_registry& add() {
+			add<T>();
+			return add<U, Rest...>();
+		}
+
+		/// <summary>
+		/// Register settings of a member, and its member type if that is not registered yet.
+		/// </summary>
+		/// <typeparam name="member">Auto-deduced member pointer</typeparam>
+		/// <param name="name">Name in the text, defaults to the ``type_name`` of the struct and the offset</param>
+		/// <exception cref="std::runtime_error">If the name is taken by another member</exception>
+		template<auto member>
+		json_registry& add_member(std::string name = default_member_name<member>()) {
+			using traits = member_pointer_traits<decltype(member)>;
+			const type_id member_type = type_id::of<typename traits::member_type>();
+			if (member_type.value >= type_index.size() || type_index[member_type.value] == detail::npos) {
+				add<typename traits::member_type>();
+			}
+
+			const member_key key{ type_id::of<typename traits::class_type>(), member_type, get_member_offset<member>() };
+			auto existing = member_index.find(key);
+			if (existing != member_index.end()) {
+				rename(members[existing->second], member_names, std::move(name));
+				return *this;
+			}
+
+			member_entry entry;
+			entry.name = std::move(name);
+			entry.member_type = member_type;
+			entry.push = [](scope_type& parent) -> scope_type& { return parent.template push_member<member>(); };
+			claim(member_names, entry.name, static_cast<std::uint32_t>(members.size()));
+			member_index.emplace(key, static_cast<std::uint32_t>(members.size()));
+			members.push_back(std::move(entry));
+			return *this;
+		}
+
+		template<auto member, auto next, auto... rest>
+		json_registry& add_member() {
+			add_member<member>();
+			return add_member<next, rest...>();
+		}
+
+	private:
+		friend struct detail::json_format<BaseTemplate>;
+
+		struct type_entry {
+			std::string name;
+			bool has_fields = false;
+			scope_type& (*push)(scope_type& parent) = nullptr;
+			void (*write_fields)(const scope_type& node, detail::json::writer& out) = nullptr;
+			detail::json::field_result (*read_field)(scope_type& node, std::string_view field, const detail::json::scalar& value) = nullptr;
+		};
+
+		struct member_entry {
+			std::string name;
+			type_id member_type;
+			scope_type& (*push)(scope_type& parent) = nullptr;
+		};
+
+		struct member_key {
+			type_id struct_type;
+			type_id member_type;
+			std::size_t offset;
+
+			bool operator==(const member_key& other) const {
+				return struct_type == other.struct_type && member_type == other.member_type && offset == other.offset;
+			}
+		};
+		struct member_key_hash {
+			std::size_t operator()(const member_key& key) const {
+				return member_hash{}(key.struct_type, key.member_type, key.offset);
+			}
+		};
+
+		template<auto member>
+		static std::string default_member_name() {
+			using traits = member_pointer_traits<decltype(member)>;
+			return std::string(type_name<typename traits::class_type>::value) + "::" + std::to_string(get_member_offset<member>());
+		}
+
+		static void claim(std::unordered_map<std::string, std::uint32_t>& names, const std::string& name, std::uint32_t index) {
+			if (!names.emplace(name, index).second) {
+				detail::raise("JSON name is already registered: " + name);
+			}
+		}
+
+		/* Registering again changes the name */
+		template<class Entry>
+		static void rename(Entry& entry, std::unordered_map<std::string, std::uint32_t>& names, std::string name) {
+			if (name == entry.name) {
+				return;
+			}
+			const std::uint32_t index = names.at(entry.name);
+			claim(names, name, index);
+			names.erase(entry.name);
+			entry.name = std::move(name);
+		}
+
+		const type_entry& type_of(type_id id) const {
+			if (id.value >= type_index.size() || type_index[id.value] == detail::npos) {
+				detail::raise("Type is not registered for JSON: " + std::string(id.name()));
+			}
+			return types[type_index[id.value]];
+		}
+
+		const member_entry& member_of(type_id struct_type, type_id member_type, std::size_t offset) const {
+			auto it = member_index.find(member_key{ struct_type, member_type, offset });
+			if (it == member_index.end()) {
+				detail::raise("Member is not registered for JSON: " + std::string(struct_type.name()) + "::" + std::to_string(offset));
+			}
+			return members[it->second];
+		}
+
+		const type_entry* find_type(const std::string& name) const {
+			auto it = type_names.find(name);
+			return it != type_names.end() ? &types[it->second] : nullptr;
+		}
+
+		const member_entry* find_member(const std::string& name) const {
+			auto it = member_names.find(name);
+			return it != member_names.end() ? &members[it->second] : nullptr;
+		}
+
+		std::vector<type_entry> types;
+		std::vector<std::uint32_t> type_index; /* type id -> types, npos if not registered */
+		std::unordered_map<std::string, std::uint32_t> type_names;
+		std::vector<member_entry> members;
+		std::unordered_map<member_key, std::uint32_t, member_key_hash> member_index;
+		std::unordered_map<std::string, std::uint32_t> member_names;
+	};
+
+	/// <summary>
+	/// Write the children of a scope, and their subtrees, as JSON.
+	/// </summary>
+	/// <param name="tree">Scope whose children are saved</param>
+	/// <param name="registry">Names of the types and members in the tree</param>
+	/// <param name="out">Stream to write to</param>
+	/// <exception cref="std::runtime_error">If a type or member in the tree is not registered, or the stream fails</exception>
+	template<template<class> class BaseTemplate>
+	void save_json(const scope<BaseTemplate>& tree, const json_registry<BaseTemplate>& registry, std::ostream& out) {
+		detail::json::writer writer(out);
+		detail::json_format<BaseTemplate>::save(tree, registry, writer);
+		if (!writer.good()) {
+			detail::raise("Could not write JSON");
+		}
+	}
+
+	/// <summary>
+	/// Push the children saved by ``save_json`` into a scope. Existing settings are kept,
+	/// saved fields overwrite them and new scopes copy from their parents like ``push``.
+	/// </summary>
+	/// <param name="tree">Scope to push the children into</param>
+	/// <param name="registry">Names of the types and members in the text</param>
+	/// <param name="in">Stream to read from</param>
+	/// <exception cref="std::runtime_error">If the text is malformed, nests nodes deeper than 256 levels or names an unregistered type, member or field</exception>
+	template<template<class> class BaseTemplate>
+	void load_json(scope<BaseTemplate>& tree, const json_registry<BaseTemplate>& registry, std::istream& in) {
+		detail::json::reader reader(in);
+		detail::json_format<BaseTemplate>::load(tree, registry, reader);
+	}
+}